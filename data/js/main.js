@@ -10,6 +10,8 @@ const wsUrl = `${wsProtocol}//${loc}/ws`; // Utilise le même hôte et protocole
 
 // Initialiser l'objet WebSocket
 export let ws; // Déclare et exporte ws comme une variable globale
+// Session de jeu du contrôleur choisie par l'URL (?session=1), 0 par défaut
+const gameSession = parseInt(new URLSearchParams(window.location.search).get('session') || '0', 10);
 let reconnectInterval = 5000; // Intervalle en millisecondes pour tenter de se reconnecter
 let pingInterval = 100000000;
 let pingTimeout;
@@ -146,7 +148,7 @@ export function connectWebSocket(onMessageCallback) {
         
         cleanBoard();
 
-        sendWebSocketMessage("HELLO", {} );
+        sendWebSocketMessage("HELLO", { SESSION: gameSession });
 
         webSocketColor();
 
@@ -1,7 +1,7 @@
 import { createTeamDiv } from './teamSPA.js';
 import { createBuzzerDiv } from './buzzerSPA.js';
 import { initializeDropzones } from './dragAndDropSPA.js'
-import { sendWebSocketMessage, ws} from './websocket.js';
+import { sendWebSocketMessage, sendWebSocketActions, ws} from './websocket.js';
  
 let teams = {};
 let bumpers = {};
@@ -96,6 +96,25 @@ export function setBumperPoint(id, inc = 0) {
     sendPoints(id, inc);
 }
 
+// Mêmes points à plusieurs bumpers: une seule trame ACTIONS, appliquée d'un bloc
+export function setBumpersPoints(ids, inc = 0) {
+    const awarded = ids.filter(id => bumpers[id]);
+    if (awarded.length === 0) return;
+
+    awarded.forEach(id => {
+        const bumper = bumpers[id];
+        const team = teams[bumper["TEAM"]];
+        if (!bumper["SCORE"]) { bumper["SCORE"] = 0; }
+        bumper["SCORE"] += inc;
+        if (team) {
+            if (!team["SCORE"]) { team["SCORE"] = 0; }
+            team["SCORE"] += inc;
+        }
+    });
+
+    sendPointsBatch(awarded, inc);
+}
+
 export function deleteTeam(id) {
     delete teams[id];
     sendTeamsAndBumpers();
@@ -140,6 +159,18 @@ export function sendPoints(bumperId, points) {
     }
 }
 
+export function sendPointsBatch(bumperIds, points) {
+    if (ws.readyState === WebSocket.OPEN) {
+        sendWebSocketActions(bumperIds.map(bumperId => ["POINTS", {
+            bumperId: bumperId,
+            points: points
+        }]));
+    } else {
+        console.log('WebSocket not ready. Retrying...');
+        setTimeout(() => sendPointsBatch(bumperIds, points), 1000);
+    }
+}
+
 export function updateDisplayConfig() {
     createTeamDiv(getTeams());
     createBuzzerDiv(getBumpers());
@@ -1,8 +1,9 @@
 import {sendWebSocketMessage} from './websocket.js';
 import { updateBumpers, updateTeams, updateDisplayConfig, configPage } from './configSPA.js';
 import { scorePage } from './scoreSPA.js';
+import { updateRanking } from './rankingSync.js';
 import { getQuestions, questionList,  getFileStorage, fsInfo, updateQuestionFromGame } from './questionsSPA.js';
-import { teamGamePage, receiveQuestion, questionsSelectList, displayQuestion, updateDisplayGame } from './teamGameSPA.js';
+import { teamGamePage, receiveQuestion, questionsSelectList, displayQuestion, updateDisplayGame, receiveBuzzOrder } from './teamGameSPA.js';
 import { getCoreVersion } from './version.js';
 
 export let gameState = {
@@ -109,6 +110,15 @@ function handleServerAction(action, msg, fsinfo, version) {
             updateTimer();
             updateTimeBar();
             break;
+        case 'BUZZ_ORDER':
+            receiveBuzzOrder(msg);
+            break;
+        case 'RANKING':
+            updateRanking(msg);
+            if (window.location.hash === "#score") {
+                scorePage();
+            }
+            break;
         case 'REVEAL':
             break;
         case 'READY':
@@ -1,3 +1,6 @@
+import { createStateSync } from './stateSync.js';
+import { rankedEntries, updateRanking } from './rankingSync.js';
+
 let gameState = {
     timer: 30,
     isRunning: false,
@@ -102,17 +105,19 @@ function handleServerAction(action, msg, msgpoints) {
                 updateScores(msg);
             }
             if (msgpoints) {
-                const { teamId, points } = msgpoints;
-
-                const teamData = msg.teams[teamId];
-
-                if (teamData && teamData.COLOR) {
-                    const color = teamData.COLOR; // Ex: [64,64,64]
-                    triggerPointsAnimation(teamId, points, color);
-                } else {
-                    console.warn(`Team ${teamId} non trouvée ou pas de couleur`);
-                    triggerPointsAnimation(teamId, points, null);
-                }
+                // Un objet par attribution; un tableau pour un lot d'actions (ACTIONS)
+                const awards = Array.isArray(msgpoints) ? msgpoints : [msgpoints];
+                awards.forEach(({ teamId, points }) => {
+                    const teamData = msg.teams ? msg.teams[teamId] : undefined;
+
+                    if (teamData && teamData.COLOR) {
+                        const color = teamData.COLOR; // Ex: [64,64,64]
+                        triggerPointsAnimation(teamId, points, color);
+                    } else {
+                        console.warn(`Team ${teamId} non trouvée ou pas de couleur`);
+                        triggerPointsAnimation(teamId, points, null);
+                    }
+                });
             }
             break;
         case 'UPDATE_TIMER':
@@ -120,6 +125,11 @@ function handleServerAction(action, msg, msgpoints) {
             updateTimer();
             updateTimeBar();
             break;
+        case 'RANKING':
+            updateRanking(msg);
+            renderTeamScores();
+            renderPlayerScores();
+            break;
         case 'REVEAL':
             showAnswer(msg)
             break;
@@ -237,12 +247,11 @@ function renderTeamScores() {
     tbody.innerHTML = '';
     const teams = getTeams();
     console.log(teams)
-    const sortedTeams = Object.entries(teams).sort((a, b) => b[1].SCORE - a[1].SCORE);
+    const sortedTeams = rankedEntries('teams', teams);
 
-    sortedTeams.forEach((team, index) => {
-        const [teamName, teamData] = team;
+    sortedTeams.forEach(({ id: teamName, rank, data: teamData }) => {
         const row = tbody.insertRow();
-        row.insertCell(0).textContent = index + 1;
+        row.insertCell(0).textContent = rank;
         const teamNameCell = row.insertCell(1)
         const teamNameDiv = document.createElement('div')
         teamNameDiv.className = 'color-cell';
@@ -261,7 +270,7 @@ function renderTeamScores() {
 
         console.log(teamData.COLOR)
         row.insertCell(2).textContent = teamData.SCORE || 0;
-        console.log('team :', team)
+        console.log('team :', teamName)
         console.log('teamdata:', teamData)
     });
 }
@@ -274,19 +283,19 @@ function renderPlayerScores() {
 
     tbody.innerHTML = '';
     const bumpers = getBumpers();
-    const sortedPlayers = Object.entries(bumpers)
-        .map(([id, data]) => ({
+    const sortedPlayers = rankedEntries('bumpers', bumpers)
+        .map(({ id, rank, data }) => ({
             id,
+            rank,
             ...data,
             SCORE: parseInt(data.SCORE) || 0
-        }))
-        .sort((a, b) => b.SCORE - a.SCORE);
+        }));
 
-    sortedPlayers.forEach((player, index) => {
+    sortedPlayers.forEach((player) => {
         const previousPosition = previousPositions[player.id];
         
         const row = tbody.insertRow();
-        row.insertCell(0).textContent = index + 1;
+        row.insertCell(0).textContent = player.rank;
         row.insertCell(1).textContent = player.NAME || `Joueur ${player.id}`;
         row.insertCell(2).textContent = player.TEAM || 'Sans équipe';
         const scoreButtonCell = row.insertCell(3);
@@ -296,13 +305,13 @@ function renderPlayerScores() {
         scoreButtonCell.appendChild(scoreText);
     
         // Vérification si le joueur a changé de position
-        if (previousPosition !== undefined && previousPosition !== index + 1) {
+        if (previousPosition !== undefined && previousPosition !== player.rank) {
             // Ajouter une classe d'animation si le joueur a changé de position
             row.classList.add('highlight');
         }
 
         // Mettre à jour la position précédente du joueur
-        previousPositions[player.id] = index + 1;
+        previousPositions[player.id] = player.rank;
     });
 
     // Nettoyage de l'animation après un certain temps
@@ -367,6 +376,7 @@ const wsProtocol = "ws:"
 const wsUrl = `${wsProtocol}//${loc}/ws`;
 let ws;
 const reconnectInterval = 5000; // 5s pour la reconnexion
+const expandStateEvent = createStateSync((action, MSG) => sendWebSocketMessage(action, MSG));
 const heartbeatInterval = 15000; // 15s pour vérifier l'état
 
 let heartbeatTimer = null;
@@ -399,7 +409,7 @@ export function connectWebSocketPlayers(onMessageCallback) {
         setTimeout(() => connectWebSocketPlayers(onMessageCallback), reconnectInterval);
     };
 
-    ws.onmessage = onMessageCallback || function(event) {
+    ws.onmessage = onMessageCallback ? (event) => onMessageCallback(expandStateEvent(event)) : function(event) {
         console.log('Message reçu:', event.data);
     };
 
@@ -0,0 +1,19 @@
+// Classement publié par le contrôleur (message RANKING ou /ranking):
+// les pages n'ont plus à trier équipes et joueurs à chaque UPDATE.
+let ranking = null;
+
+export function updateRanking(msg) {
+    ranking = msg;
+}
+
+// Entrées ordonnées {id, rank, delta, data}; repli sur un tri local tant qu'aucun RANKING n'est reçu
+export function rankedEntries(kind, entities) {
+    if (ranking && Array.isArray(ranking[kind])) {
+        return ranking[kind]
+            .filter(entry => entities[entry.ID])
+            .map(entry => ({ id: entry.ID, rank: entry.RANK, delta: entry.DELTA || 0, data: entities[entry.ID] }));
+    }
+    return Object.entries(entities)
+        .sort((a, b) => (parseInt(b[1].SCORE) || 0) - (parseInt(a[1].SCORE) || 0))
+        .map(([id, data], index) => ({ id, rank: index + 1, delta: 0, data }));
+}
@@ -1,5 +1,6 @@
 import { sendWebSocketMessage } from './websocket.js';
 import { updateBumpers, updateTeams, getTeams, getBumpers, setBumperPoint, } from './configSPA.js';
+import { rankedEntries } from './rankingSync.js';
 
 function updateScores(data) {
     if (data.teams) updateTeams(data.teams);
@@ -19,12 +20,11 @@ function renderTeamScores() {
     tbody.innerHTML = '';
     const teams = getTeams();
     console.log(teams)
-    const sortedTeams = Object.entries(teams).sort((a, b) => b[1].SCORE - a[1].SCORE);
+    const sortedTeams = rankedEntries('teams', teams);
 
-    sortedTeams.forEach((team, index) => {
-        const [teamName, teamData] = team;
+    sortedTeams.forEach(({ id: teamName, rank, data: teamData }) => {
         const row = tbody.insertRow();
-        row.insertCell(0).textContent = index + 1;
+        row.insertCell(0).textContent = rank;
 
         const teamNameCell = row.insertCell(1);
         const teamNameDiv = document.createElement('div');
@@ -45,12 +45,12 @@ function renderTeamScores() {
         row.insertCell(2).textContent = teamData.SCORE || 0;
 
         // Ajout de la classe highlight si la position de l'équipe change
-        if (previousTeamPositions[teamName] !== undefined && previousTeamPositions[teamName] !== index + 1) {
+        if (previousTeamPositions[teamName] !== undefined && previousTeamPositions[teamName] !== rank) {
             row.classList.add('highlight');
         }
 
         // Mettre à jour la position précédente de l'équipe
-        previousTeamPositions[teamName] = index + 1;
+        previousTeamPositions[teamName] = rank;
     });
 
     // Nettoyage de l'animation après un certain temps
@@ -67,19 +67,19 @@ function renderPlayerScores() {
     const bumpers = getBumpers();
     const teams = getTeams();
 
-    const sortedPlayers = Object.entries(bumpers)
-        .map(([id, data]) => ({
+    const sortedPlayers = rankedEntries('bumpers', bumpers)
+        .map(({ id, rank, data }) => ({
             id,
+            rank,
             ...data,
             SCORE: parseInt(data.SCORE) || 0
-        }))
-        .sort((a, b) => b.SCORE - a.SCORE);
+        }));
 
-    sortedPlayers.forEach((player, index) => {
+    sortedPlayers.forEach((player) => {
         const previousPosition = previousPlayerPositions[player.id];
 
         const row = tbody.insertRow();
-        row.insertCell(0).textContent = index + 1;
+        row.insertCell(0).textContent = player.rank;
         row.insertCell(1).textContent = player.NAME || `Joueur ${player.id}`;
 
         const teamNameCell = row.insertCell(2);
@@ -117,11 +117,11 @@ function renderPlayerScores() {
         scoreCell.appendChild(scoreText);
 
         // Animation si changement de position
-        if (previousPosition !== undefined && previousPosition !== index + 1) {
+        if (previousPosition !== undefined && previousPosition !== player.rank) {
             row.classList.add('highlight');
         }
 
-        previousPlayerPositions[player.id] = index + 1;
+        previousPlayerPositions[player.id] = player.rank;
     });
 
     setTimeout(() => {
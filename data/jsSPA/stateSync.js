@@ -0,0 +1,66 @@
+// Reconstitue l'état complet à partir des UPDATE versionnés du serveur.
+// Un UPDATE porte STATE_VERSION; s'il porte DELTA, MSG ne contient que les champs modifiés
+// depuis BASE_VERSION (null = champ ou entité supprimé). Les handlers reçoivent toujours l'état complet.
+
+export function createStateSync(send) {
+    let state = { bumpers: {}, teams: {}, GAME: {} };
+    let version = null;
+
+    function mergeFields(dest, src) {
+        for (const [key, value] of Object.entries(src || {})) {
+            if (value === null) {
+                delete dest[key];
+            } else {
+                dest[key] = value;
+            }
+        }
+    }
+
+    function mergeEntities(dest, src) {
+        for (const [id, fields] of Object.entries(src || {})) {
+            if (fields === null) {
+                delete dest[id];
+            } else {
+                dest[id] = dest[id] || {};
+                mergeFields(dest[id], fields);
+            }
+        }
+    }
+
+    function apply(message) {
+        const msg = message.MSG || {};
+
+        if (message.DELTA) {
+            if (version !== message.BASE_VERSION) {
+                console.warn(`State gap: have ${version}, delta from ${message.BASE_VERSION} => RESYNC`);
+                send("RESYNC", {});
+            }
+            mergeEntities(state.bumpers, msg.bumpers);
+            mergeEntities(state.teams, msg.teams);
+            mergeFields(state.GAME, msg.GAME);
+        } else {
+            if (msg.bumpers) state.bumpers = msg.bumpers;
+            if (msg.teams) state.teams = msg.teams;
+            if (msg.GAME) state.GAME = msg.GAME;
+        }
+        if (message.STATE_VERSION !== undefined) {
+            version = message.STATE_VERSION;
+        }
+        message.MSG = structuredClone(state);
+        return message;
+    }
+
+    // Filtre un évènement WebSocket: les UPDATE sont réécrits avec l'état complet
+    return function expandStateEvent(event) {
+        let message;
+        try {
+            message = JSON.parse(event.data);
+        } catch (e) {
+            return event;
+        }
+        if (message.ACTION !== "UPDATE" || message.STATE_VERSION === undefined) {
+            return event;
+        }
+        return { data: JSON.stringify(apply(message)) };
+    };
+}
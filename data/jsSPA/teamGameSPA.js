@@ -1,9 +1,16 @@
 import { gameState } from './interface.js';
-import { getBumpers, getTeams, setBumperPoint } from './configSPA.js'
+import { getBumpers, getTeams, setBumperPoint, setBumpersPoints } from './configSPA.js'
 import { getQuestions, questions } from './questionsSPA.js';
 import { sendAction } from './interface.js';
 
 let selectedQuestion = {};
+let buzzOrder = null;
+
+// Ordre global des appuis (message BUZZ_ORDER): rang de chaque équipe et équipe qui a la main
+export function receiveBuzzOrder(msg) {
+    buzzOrder = msg;
+    updateDisplayGame();
+}
 
 export function updateDisplayGame() {
     console.log('Mise à jour de l\'affichage avec l\'état du jeu:', gameState);
@@ -50,8 +57,33 @@ export function updateDisplayGame() {
 
         teamHeader.appendChild(teamColor);
         teamHeader.appendChild(teamTitle);
+
+        const buzzRank = buzzOrder && buzzOrder.teams ? buzzOrder.teams.indexOf(teamName) : -1;
+        if (buzzRank >= 0) {
+            const firstPress = buzzOrder.presses.find(press => press.TEAM === teamName);
+            const teamRank = document.createElement('p');
+            teamRank.className = 'buzz-rank';
+            teamRank.textContent = `#${buzzRank + 1}` + (buzzRank > 0 && firstPress ? ` (+${(firstPress.DELAY / 1000).toFixed(1)} ms)` : '');
+            teamHeader.appendChild(teamRank);
+            if (buzzOrder.CURRENT === teamName) {
+                teamElement.classList.add('current-turn');
+                if (buzzRank + 1 < buzzOrder.teams.length) {
+                    const nextButton = document.createElement('button');
+                    nextButton.textContent = 'Équipe suivante';
+                    nextButton.onclick = () => sendAction('BUZZ_NEXT');
+                    teamHeader.appendChild(nextButton);
+                }
+            }
+        }
         teamElement.appendChild(teamHeader);
 
+        if (gameState.gamePhase === 'STOP' && isTeamActive) {
+            teamHeader.onclick = (event) => {
+                if (event.target.tagName !== 'BUTTON') addPointToTeam(teamName);
+            };
+            teamHeader.style.cursor = 'pointer';
+        }
+
         const teamBumpers = Object.entries(getBumpers())
             .filter(([_, bumperData]) => bumperData.TEAM === teamName)
             .sort((a, b) => {
@@ -107,6 +139,19 @@ function addPointToBumper(bumperMac) {
     }
 }
 
+// Points à chaque bumper de l'équipe qui a buzzé, en une seule trame
+function addPointToTeam(teamName) {
+    if (gameState.gamePhase === 'STOP') {
+        const pointsInput = document.getElementById('game-points-input');
+        const pointsValue = parseInt(pointsInput.value, 10);
+        const activeBumpers = Object.entries(getBumpers())
+            .filter(([_, bumperData]) => bumperData.TEAM === teamName
+                && (bumperData.BUTTON !== undefined || bumperData.TIMESTAMP !== undefined))
+            .map(([bumperMac]) => bumperMac);
+        setBumpersPoints(activeBumpers, pointsValue || 1);
+        updateDisplayGame();
+    }
+}
 
 export function receiveQuestion(data) {
     if (!data || Object.keys(data).length === 0) {
@@ -1,4 +1,5 @@
 import { handleConfigSocketMessage } from './interface.js';
+import { createStateSync } from './stateSync.js';
 
 // Connectez-vous au serveur WebSocket
 //const loc = window.location;
@@ -9,9 +10,12 @@ const wsProtocol = "ws:"
 const wsUrl = `${wsProtocol}//${loc}/ws`; // Utilise le même hôte et protocole que la page
 
 export let ws; // Déclare et exporte ws comme une variable globale
+// Session de jeu du contrôleur choisie par l'URL (?session=1), 0 par défaut
+const gameSession = parseInt(new URLSearchParams(window.location.search).get('session') || '0', 10);
 let reconnectInterval = 5000; // Intervalle en millisecondes pour tenter de se reconnecter
 let pingInterval = 100000000;
 let pingTimeout;
+const expandStateEvent = createStateSync((action, MSG) => sendWebSocketMessage(action, MSG));
 
 function webSocketColor() {
     let webSocketColorDiv = document.getElementById('websocket-tracker');
@@ -64,7 +68,7 @@ export function connectWebSocket(onMessageCallback) {
         // Nettoyage du tableau lors de la reconnexion
         //cleanBoard();
 
-        sendWebSocketMessage("HELLO", {} );
+        sendWebSocketMessage("HELLO", { SESSION: gameSession });
 
         webSocketColor();
 
@@ -87,7 +91,7 @@ export function connectWebSocket(onMessageCallback) {
         stopPing();
     };
 
-    ws.onmessage = onMessageCallback || function(event) {
+    ws.onmessage = onMessageCallback ? (event) => onMessageCallback(expandStateEvent(event)) : function(event) {
         console.log('Message reçu:', event.data);
         resetPing();
     };
@@ -132,4 +136,11 @@ export function sendWebSocketMessage (action, MSG= "{}")  {
     }
 };
 
+// Plusieurs actions en une trame, appliquées d'un bloc: [["POINTS", {...}], ["POINTS", {...}]]
+export function sendWebSocketActions (actions)  {
+    sendWebSocketMessage("ACTIONS", {
+        "ACTIONS": actions.map(([action, MSG]) => ({ "ACTION": action, "MSG": MSG }))
+    });
+};
+
 connectWebSocket(handleConfigSocketMessage);
\ No newline at end of file
@@ -73,7 +73,7 @@ void hello_bumper();
 void attachButtons();
 void detachButtons();
 void manageButtonMessages();
-void handleUpdateAction(JsonObject& message, const String& macAddress);
+void handleUpdateAction(JsonObject& root, JsonObject& message, const String& macAddress);
 bool wifiConnect();
 void parseJSON(const String& data, AsyncClient* c);
 
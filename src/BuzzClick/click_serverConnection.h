@@ -2,11 +2,17 @@
 #include "click_includes.h"
 #include "Common/CustomLogger.h"
 #include "Common/led.h"
+#include "Common/jsonArena.h"
 
 #include <esp_timer.h>
 #include <AsyncUDP.h>
 
 JsonDocument myCompleteConfig;  // Store the complete configuration
+// Arènes des messages reçus: TCP et UDP arrivent dans deux tâches différentes (async_tcp,
+// async_udp). Chacune est liée à sa tâche une fois, au premier callback qui y tourne.
+JsonArena tcpArena("tcp", 4 * 1024);
+JsonArena udpArena("udp", 8 * 1024);
+bool udpArenaBound = false;
 bool isConfigInitialized = false;
 
 String myConfig="{ }";
@@ -15,6 +21,8 @@ uint64_t lastNTPUpdate = 0;
 int64_t ntpOffset = 0;
 
 bool isGameStarted = false;
+// Session de jeu du contrôleur à laquelle appartient ce buzzer (message SESSION reçu en TCP)
+uint8_t mySession = 0;
 
 //const int CONTROLER_PORT = 1234;
 
@@ -93,6 +101,8 @@ bool getServerIP()
 
 void onConnect(void* arg, AsyncClient* c) {
   ESP_LOGI(SRV_TAG, "Connected to server: %s:%d", c->remoteIP().toString().c_str(), c->remotePort());
+  // Premier callback de la connexion, avant toute donnée: la tâche async_tcp prend son arène
+  bindTaskArena(&tcpArena);
   hello_bumper();
 }
 
@@ -194,6 +204,10 @@ bool initBroadcastUDP()
   ESP_LOGI(SRV_TAG, "UDP listening on port %d", CONTROLER_PORT);
 
   udp.onPacket([](AsyncUDPPacket packet) {
+    if (!udpArenaBound) {
+      bindTaskArena(&udpArena);
+      udpArenaBound = true;
+    }
     onDataBroadcast(packet);
   });
 
@@ -289,29 +303,117 @@ ESP_LOGI(SRV_TAG, "Game Phase=%s",game_phase);
   }
 }
 
-void handleUpdateAction(JsonObject& message, const String& macAddress) {
+// Version d'état du dernier UPDATE appliqué (STATE_VERSION du serveur)
+uint32_t lastStateVersion = 0;
+
+JsonObject stateSection(const char* key) {
+  JsonVariant section = myCompleteConfig["state"][key];
+  if (section.is<JsonObject>()) {
+    return section.as<JsonObject>();
+  }
+  return myCompleteConfig["state"][key].to<JsonObject>();
+}
+
+// Fusionne les champs d'une entité: un champ null est supprimé
+void mergeStateFields(JsonObject dest, JsonObjectConst src) {
+  for (JsonPairConst kv : src) {
+    if (kv.value().isNull()) {
+      dest.remove(kv.key());
+    } else {
+      dest[kv.key()] = kv.value();
+    }
+  }
+}
+
+// Fusionne l'entrée "id" d'une section bumpers/teams d'un delta: une entité null a été supprimée.
+// Les autres entrées ne concernent pas ce buzzer et sont ignorées.
+void mergeStateEntity(const char* key, JsonObjectConst src, const char* id) {
+  if (id[0] == '\0' || !src.containsKey(id)) return;
+  JsonObject dest = stateSection(key);
+  JsonVariantConst value = src[id];
+  if (value.isNull()) {
+    dest.remove(id);
+    return;
+  }
+  JsonVariant entity = dest[id];
+  JsonObject entityObj = entity.is<JsonObject>() ? entity.as<JsonObject>() : dest[id].to<JsonObject>();
+  mergeStateFields(entityObj, value.as<JsonObjectConst>());
+}
+
+// Remplace une section bumpers/teams par la seule entrée "id" du snapshot
+void keepStateEntity(const char* key, JsonObjectConst src, const char* id) {
+  JsonObject dest = myCompleteConfig["state"][key].to<JsonObject>();
+  if (id[0] != '\0' && src[id].is<JsonObjectConst>()) {
+    dest[id] = src[id];
+  }
+}
+
+String myStateTeam(const char* macAddress) {
+  return myCompleteConfig["state"]["bumpers"][macAddress]["TEAM"] | "";
+}
+
+// Applique un UPDATE sur l'état mémorisé: snapshot (sections remplacées) ou delta versionné (fusion).
+// Seuls l'entrée de ce buzzer, celle de son équipe, GAME et la version sont gardés: l'état
+// complet de la partie ne tient pas dans la mémoire d'un buzzer.
+// Un trou de version (UDP perdu) déclenche une demande de RESYNC au serveur.
+void applyStateUpdate(JsonObjectConst root, JsonObjectConst message, const char* macAddress) {
+  bool isDelta = root["DELTA"] | false;
+
+  if (isDelta) {
+    uint32_t base = root["BASE_VERSION"] | 0;
+    bool resync = base != lastStateVersion;
+    if (resync) {
+      ESP_LOGW(SRV_TAG, "State gap: have %u, delta from %u => RESYNC", lastStateVersion, base);
+    }
+    String previousTeam = myStateTeam(macAddress);
+    mergeStateEntity("bumpers", message["bumpers"], macAddress);
+    String team = myStateTeam(macAddress);
+    if (team != previousTeam) {
+      // Nouvelle équipe: le delta n'en porte que les champs modifiés, le snapshot complet suivra
+      myCompleteConfig["state"]["teams"].to<JsonObject>();
+      if (team.length() > 0 && !resync) {
+        ESP_LOGI(SRV_TAG, "Team changed to %s => RESYNC", team.c_str());
+        resync = true;
+      }
+    } else {
+      mergeStateEntity("teams", message["teams"], team.c_str());
+    }
+    mergeStateFields(stateSection("GAME"), message["GAME"]);
+    if (resync) {
+      sendMSG("RESYNC", "{}");
+    }
+  } else {
+    if (message["bumpers"].is<JsonObjectConst>()) keepStateEntity("bumpers", message["bumpers"], macAddress);
+    if (message["teams"].is<JsonObjectConst>()) keepStateEntity("teams", message["teams"], myStateTeam(macAddress).c_str());
+    if (message["GAME"].is<JsonObjectConst>()) myCompleteConfig["state"]["GAME"] = message["GAME"];
+  }
+
+  if (root["STATE_VERSION"].is<uint32_t>()) {
+    lastStateVersion = root["STATE_VERSION"];
+  }
+}
+
+void handleUpdateAction(JsonObject& root, JsonObject& message, const String& macAddress) {
   JsonObject buzzer;
   JsonObject team;
   String output;
-  JsonDocument JsonDoc;
+  JsonDocument JsonDoc(taskJsonAllocator());
   JsonArray colorArray = JsonDoc.to<JsonArray>();
   colorArray.add(0);
   colorArray.add(0);
   colorArray.add(0);
 
-  // Check if we're receiving a bumper update for our device
-  if (message.containsKey("bumpers") && message["bumpers"].containsKey(macAddress)) {
-    // Extract the bumper config for our device
-    buzzer = message["bumpers"][macAddress].as<JsonObject>();
-    
-      myCompleteConfig["buzzer"] = buzzer;
-      isConfigInitialized = true;
-    
+  applyStateUpdate(root, message, macAddress.c_str());
+  JsonObject state = myCompleteConfig["state"];
+
+  // Check if the known state has a bumper entry for our device
+  if (state["bumpers"][macAddress].is<JsonObject>()) {
+    buzzer = state["bumpers"][macAddress].as<JsonObject>();
+    isConfigInitialized = true;
   }
 
-  buzzer = myCompleteConfig["buzzer"].as<JsonObject>();
     // Log current buzzer config
-  serializeJson(myCompleteConfig["buzzer"], output);
+  serializeJson(buzzer, output);
   ESP_LOGI(SRV_TAG, "My Config=%s", output.c_str());
   myConfig = output;
 
@@ -322,19 +424,15 @@ void handleUpdateAction(JsonObject& message, const String& macAddress) {
     t_name = buzzer["TEAM"];
     ESP_LOGI(SRV_TAG, "My team=%s", t_name);
     
-    if (message.containsKey("teams") && message["teams"].containsKey(t_name)) {
-      team = message["teams"][t_name];
-      
-      // Store/update the team information in our complete config
-      myCompleteConfig["team"] = team;
+    if (state["teams"][t_name].is<JsonObject>()) {
+      team = state["teams"][t_name];
       
+      output = "";
       serializeJson(team, output);
       ESP_LOGI(SRV_TAG, "    =>%s", output.c_str());
     }
   }
 
-  team = myCompleteConfig["team"].as<JsonObject>();
-
   // Extract color information
   int r = 0, g = 0, b = 0;
   if (team.containsKey("COLOR")) {
@@ -369,11 +467,8 @@ void handleUpdateAction(JsonObject& message, const String& macAddress) {
     }
   }
   
-  // Always store the full message for reference
-  myCompleteConfig["lastMessage"] = message;
-  
-  // Apply LED settings
-  manageLeds(buzzer, team, colorArray, message);
+  // Apply LED settings (GAME vient de l'état fusionné)
+  manageLeds(buzzer, team, colorArray, state);
 }
 
 
@@ -389,7 +484,9 @@ void resetGame() {
 }
 
 void parseJSON(const String& data, AsyncClient* c) {
-  JsonDocument receivedData;
+  JsonArena& arena = (c != nullptr) ? tcpArena : udpArena;
+  JsonArenaScope arenaScope(arena);  // libère tout le message en sortie
+  JsonDocument receivedData(&arena);
   ESP_LOGD(SRV_TAG, " parse JSON: %s", data.c_str());
 
   DeserializationError error = deserializeJson(receivedData, data);
@@ -401,6 +498,12 @@ void parseJSON(const String& data, AsyncClient* c) {
   const char* action = receivedData["ACTION"];
   JsonObject message = receivedData["MSG"];
   ESP_LOGD(SRV_TAG, "Parsing ACTION=%s", action);
+
+  // Broadcast UDP d'une autre session du contrôleur: pas pour nous
+  if (c == nullptr && !receivedData["SESSION"].isNull() && (receivedData["SESSION"] | 0) != mySession) {
+    ESP_LOGD(SRV_TAG, "Ignoring %s from session %u", action, receivedData["SESSION"] | 0);
+    return;
+  }
  // Utiliser un switch case avec hash pour un traitement plus rapide et plus propre
   switch (hash(action)) {
     case hash("START"):
@@ -429,7 +532,10 @@ void parseJSON(const String& data, AsyncClient* c) {
     case hash("UPDATE_TIMER"):
       ESP_LOGI(SRV_TAG, action[0] == 'U' ? "Updating My Config: %s" : "UPDATING TIMER", 
                WiFi.macAddress().c_str());
-      handleUpdateAction(message, WiFi.macAddress());
+      {
+        JsonObject root = receivedData.as<JsonObject>();
+        handleUpdateAction(root, message, WiFi.macAddress());
+      }
       break;
       
     case hash("HELLO"):
@@ -441,11 +547,25 @@ void parseJSON(const String& data, AsyncClient* c) {
       ESP_LOGI(SRV_TAG, "Resetting Data");
       resetGame();
       break;
+
+    case hash("SESSION"):
+      {
+        uint8_t session = message["SESSION"] | 0;
+        if (session != mySession) {
+          // Les versions d'état de l'autre session ne s'enchaînent pas: repartir d'un snapshot
+          ESP_LOGI(SRV_TAG, "Joining session %u", session);
+          mySession = session;
+          lastStateVersion = 0;
+          sendMSG("RESYNC", "{}");
+        }
+      }
+      break;
       
     default:
       ESP_LOGW(SRV_TAG, "Unknown action: %s", action);
       break;
   }
+  arena.logUsage();
 }
 
 int64_t getAbsoluteTimeMicros() {
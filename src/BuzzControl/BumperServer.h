@@ -12,50 +12,62 @@
 //#include "jsonManager.h"
 
 static const char* BUMPER_TAG = "BUMPER_SERVER";
-String gamePhase = "STOP"; /* STARTED PAUSED */
 int gameStartTimeStamp = 0;
-// Déclaration du Ticker global
-Ticker gameTimer;
+// Décompte de chaque session, indépendant des autres
+Ticker gameTimers[MAX_SESSIONS];
 
 // Flag pour suivre l'état du timer
-bool isTimerRunning = false;
+bool isTimerRunning[MAX_SESSIONS] = {};
 
-void timerCallback() {
-    if (getGamePhase() == "START") {
-        updateTimer(getGameCurrentTime(), -1);
-    }
+// Tâche esp_timer: le décompte est appliqué par la tâche de réception
+void timerCallback(uint32_t session) {
+    postGameCommand(GameCommandType::TIMER_TICK, session);
 }
 
-void processButtonPress(const String& bumperID, const char* b_team, int64_t b_time, String b_button) {
-  ESP_LOGI(BUMPER_TAG, "Button Pressed %s@%s at time %lld", b_button, bumperID.c_str(), b_time);
-  if (xSemaphoreTake(questionMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-    int64_t bTime = getBumperTime(bumperID.c_str());
-    int64_t teamTime = getTeamTime(b_team);
-    ESP_LOGI(BUMPER_TAG, "Button Pressed %s: existing time %i", b_button, bTime);
-    ESP_LOGI(BUMPER_TAG, "Button Pressed %s for team %s: existing Team time %lld", b_button, b_team, teamTime);
-    if (bTime == 0)
-    {
-      setBumperButton(bumperID.c_str(), b_button);
-      setBumperTime(bumperID.c_str(), b_time);
-      setBumperStatus(bumperID.c_str(), "PAUSE");
-    }
+// Arbitrage d'un appui: tout se fait sur les slots, sans recherche par chaîne
+void processButtonPress(slot_t bumper, int64_t b_time, const char* b_button) {
+  slot_t team = gameStore().bumperHot[bumper].team;
+  ESP_LOGI(BUMPER_TAG, "Button Pressed %s@%s at time %lld", b_button, bumperIdOf(bumper), b_time);
+  if (team == NO_SLOT) {
+    return;
+  }
+  bool teamChanged = false;
+  // Tous les appuis sont classés, pas seulement le premier de chaque bumper/équipe
+  recordBuzzPress(bumper, team, b_time, b_button);
+  BumperHot& b = bumperRound(bumper);
+  TeamHot& t = teamRound(team);
+  ESP_LOGI(BUMPER_TAG, "Button Pressed %s: existing time %lld", b_button, b.timestamp);
+  ESP_LOGI(BUMPER_TAG, "Button Pressed %s for team %s: existing Team time %lld", b_button, teamIdOf(team), t.timestamp);
+  if (b.timestamp == 0)
+  {
+    copyFixed(b.button, sizeof(b.button), b_button);
+    b.timestamp = b_time;
+    b.status = EntityStatus::PAUSE;
+    markBumper(bumper, BF_BUTTON);
+    markBumper(bumper, BF_TIMESTAMP);
+    markBumper(bumper, BF_STATUS);
+  }
 
-    
-    ESP_LOGD(BUMPER_TAG, "Actual Team Time %s:%lld/%lld", b_team, teamTime, b_time);
-    if (teamTime == 0 || teamTime > b_time) {
-      setTeamBumper(b_team, bumperID.c_str());
-      setTeamTime(b_team, b_time);
-      setTeamStatus(b_team, "PAUSE");
-      enqueueOutgoingMessage("UPDATE", getTeamsAndBumpersJSON().c_str(), false, nullptr,"");
-    }
-    else {
-      ESP_LOGD(BUMPER_TAG, "Actual Team Time already setup %s:%lld", b_team, teamTime);
-    }
-    
-    xSemaphoreGive(questionMutex);
-  } else {
-        // Le mutex n'a pas pu être obtenu après le timeout
-        ESP_LOGI(BUMPER_TAG, "Couldn't obtain mutex in processButtonPress");
+  
+  ESP_LOGD(BUMPER_TAG, "Actual Team Time %s:%lld/%lld", teamIdOf(team), t.timestamp, b_time);
+  if (t.timestamp == 0 || t.timestamp > b_time) {
+    t.bumper = bumper;
+    t.timestamp = b_time;
+    t.status = EntityStatus::PAUSE;
+    markTeam(team, TF_BUMPER);
+    markTeam(team, TF_TIMESTAMP);
+    markTeam(team, TF_STATUS);
+    teamChanged = true;
+  }
+  else {
+    ESP_LOGD(BUMPER_TAG, "Actual Team Time already setup %s:%lld", teamIdOf(team), t.timestamp);
+  }
+  
+  if (teamChanged) {
+    enqueueStateUpdate();
+  }
+  if (isBuzzOrderChanged()) {
+    enqueueBuzzOrder();
   }
 }
 
@@ -69,60 +81,91 @@ void sendGame() {
 }
 
 void sendTeamsAndBumpers() {
-  enqueueOutgoingMessage("UPDATE", getTeamsAndBumpersJSON().c_str(), false, nullptr,"");
+  enqueueStateUpdate();
 }
 
 void resetBumpersTime() {
-  std::vector<String> keysToRemove = {"STATUS", "BUTTON", "TIME", "TIMESTAMP", "BUMPER"};
-
-  JsonObject bumpers = teamsAndBumpers["bumpers"];
-  JsonObject teams = teamsAndBumpers["teams"];
+  resetRoundFields();
+  resetBuzzOrder();
+  enqueueBuzzOrder();
   
-  for (JsonPair kvp : bumpers) {
-    if (kvp.value().is<JsonObject>()) {
-      JsonObject bumper = kvp.value().as<JsonObject>();
-      for (const String& key : keysToRemove) {
-        bumper.remove(key);
-      }
-    } else {
-      ESP_LOGE(BUMPER_TAG, "Error: Bumper entry is not a JsonObject");
-    }
+  timeRef = 0;
+}
+
+//#### PHASE HOOKS ###
+// Effets de bord des transitions (gamePhase.h): diffusion, LED et timer
+
+void onEnterStart(GamePhase from, GamePhase to, PhaseEvent event) {
+  // START ou CONTINUE
+  enqueueOutgoingMessage(phaseEventName(event), getGameJSON().c_str(), true, nullptr,"");
+  setLedByState(GameState::START);  
+  session_t session = currentSession();
+  if (!isTimerRunning[session]) {
+      gameTimers[session].attach(1.0, timerCallback, (uint32_t)session);
+      isTimerRunning[session] = true;
   }
-  
-  for (JsonPair team : teams) {
-    if (team.value().is<JsonObject>()) {
-      JsonObject teamData = team.value().as<JsonObject>();
-      for (const String& key : keysToRemove) {
-        teamData.remove(key);
-      }
-    } else {
-      ESP_LOGE(BUMPER_TAG, "Error: Team entry is not a JsonObject");
-    }
+}
+
+void onExitStart(GamePhase from, GamePhase to, PhaseEvent event) {
+  // Le décompte ne tourne qu'en START
+  session_t session = currentSession();
+  if (isTimerRunning[session]) {
+      gameTimers[session].detach();
+      isTimerRunning[session] = false;
   }
-  
-  timeRef = 0;
-  for (const auto& pair : timeRefTeam) {
-    timeRefTeam[pair.first] = 0;
+}
+
+void onEnterStop(GamePhase from, GamePhase to, PhaseEvent event) {
+  if (event == PhaseEvent::REVEAL) {
+    String msg = "\"" + getQuestionResponse() + "\"";
+    enqueueOutgoingMessage("REVEAL", msg.c_str(), true, nullptr,"");
+    setLedByState(GameState::REVEAL);  
+  } else {
+    enqueueOutgoingMessage("STOP", getGameJSON().c_str(), true, nullptr,"");
+    setLedByState(GameState::STOP);  
   }
 }
 
+void onEnterPause(GamePhase from, GamePhase to, PhaseEvent event) {
+  enqueueOutgoingMessage("PAUSE", getGameJSON().c_str(), true, nullptr,"");
+  setLedByState(GameState::PAUSE);  
+}
+
+void onEnterPrepare(GamePhase from, GamePhase to, PhaseEvent event) {
+  // Entre deux manches: le pool des champs froids est recopié s'il a trop grossi
+  compactColdFields();
+  sendTeamsAndBumpers();
+  enqueueOutgoingMessage("PING", "{}", false, nullptr,"");
+  setLedByState(GameState::PREPARE);  
+}
+
+void onEnterReady(GamePhase from, GamePhase to, PhaseEvent event) {
+  enqueueOutgoingMessage("READY", getTeamsAndBumpersJSON().c_str(), true, nullptr,"");
+  setLedByState(GameState::READY);  
+}
+
+void initGamePhaseHooks() {
+  onPhaseEntry(GamePhase::START, onEnterStart);
+  onPhaseExit(GamePhase::START, onExitStart);
+  onPhaseEntry(GamePhase::STOP, onEnterStop);
+  onPhaseEntry(GamePhase::PAUSE, onEnterPause);
+  onPhaseEntry(GamePhase::PREPARE, onEnterPrepare);
+  onPhaseEntry(GamePhase::READY, onEnterReady);
+}
+
 void startGame(const int delay) {
   ESP_LOGD(BUMPER_TAG, "STARTING GAME: %i ", delay);
+  if (!canFirePhase(PhaseEvent::START)) {
+    return;
+  }
   int newDelay = delay;
   
   resetBumpersTime();
   setGameDelay(newDelay);
   setGameCurrentTime(newDelay);
   setGameTime();
-  setGamePhase("START");
   setQuestionStatus("STARTED");
-  enqueueOutgoingMessage("START", getGameJSON().c_str(), true, nullptr,"");
-  setLedByState(GameState::START);  
-  // Démarrer le timer s'il n'est pas déjà en cours
-  if (!isTimerRunning) {
-      gameTimer.attach(1.0, timerCallback);
-      isTimerRunning = true;
-  }
+  fireGamePhase(PhaseEvent::START);
 }
 
 void updateTimer(const int Time, const int delta) {
@@ -138,16 +181,12 @@ void updateTimer(const int Time, const int delta) {
 }
 
 void stopGame() {
+  if (!canFirePhase(PhaseEvent::STOP)) {
+    return;
+  }
   setGameCurrentTime(0);
-  setGamePhase("STOP");
   setQuestionStatus("STOPPED");
-  enqueueOutgoingMessage("STOP", getGameJSON().c_str(), true, nullptr,"");
-  setLedByState(GameState::STOP);  
-  // Arrêter le timer
-  if (isTimerRunning) {
-      gameTimer.detach();
-      isTimerRunning = false;
-  }
+  fireGamePhase(PhaseEvent::STOP);
 }
 
 void pauseGame(AsyncClient* client) {
@@ -156,51 +195,59 @@ void pauseGame(AsyncClient* client) {
 }
 
 void pauseAllGame() {
-  setGamePhase("PAUSE");
+  if (!canFirePhase(PhaseEvent::PAUSE)) {
+    return;
+  }
   setQuestionStatus("PAUSED");
-  enqueueOutgoingMessage("PAUSE", getGameJSON().c_str(), true, nullptr,"");
-  setLedByState(GameState::PAUSE);  
+  fireGamePhase(PhaseEvent::PAUSE);
 }
 
 void continueGame() {
-  setGamePhase("START");
+  if (!canFirePhase(PhaseEvent::CONTINUE)) {
+    return;
+  }
   setQuestionStatus("STARTED");
-  enqueueOutgoingMessage("CONTINUE", getGameJSON().c_str(), true, nullptr,"");
-  setLedByState(GameState::START);  
+  fireGamePhase(PhaseEvent::CONTINUE);
 }
 
 void revealGame() {
-    if (isGameStopped()) {
-      String msg = "\"" + getQuestionResponse() + "\"";
+    if (canFirePhase(PhaseEvent::REVEAL)) {
       setQuestionStatus("REVEALED");
-      enqueueOutgoingMessage("REVEAL", msg.c_str(), true, nullptr,"");
-      setLedByState(GameState::REVEAL);  
+      fireGamePhase(PhaseEvent::REVEAL);
     }
 }
 
-void updateScore(const String bumperID, const int points) {
-  ESP_LOGD(BUMPER_TAG, "Bumper update %s %i", bumperID.c_str(), points);
-  int bscore=updateBumperScore(bumperID.c_str(), points);
-  int tscore=updateBumperTeamScore(bumperID.c_str(), points);
-  String update="\"POINTS\": {";
-  update+="\"bumperId\": \""+bumperID+"\"";
-  update+=", \"teamId\": \""+String(getBumperTeam(bumperID.c_str()))+"\"";
-  update+=", \"points\": "+String(points);
-  update+=", \"scoreBumper\": "+String(bscore);
-  update+=", \"scoreTeam\": "+String(tscore);
-  
-  update+="}";
-  enqueueOutgoingMessage("UPDATE", getTeamsAndBumpersJSON().c_str(), false, nullptr, update.c_str());
+void updateScore(const char* bumperID, const int points) {
+  ESP_LOGD(BUMPER_TAG, "Bumper update %s %i", bumperID, points);
+  slot_t slot = allocBumperSlot(bumperID);
+  if (slot == NO_SLOT) return;
+  LedgerRecord record = awardScore(slot, points, getCurrentQuestionID(), micros());
+  // Identifiants stockés en taille fixe (MAC, nom d'équipe): fragment formaté sur la pile
+  char award[256];
+  snprintf(award, sizeof(award),
+           "{\"bumperId\": \"%s\", \"teamId\": \"%s\", \"points\": %d, \"scoreBumper\": %ld, \"scoreTeam\": %ld, \"seq\": %lu}",
+           bumperIdOf(slot), record.team != NO_SLOT ? teamIdOf(record.team) : "", points,
+           (long)gameStore().bumperHot[slot].score,
+           (long)(record.team != NO_SLOT ? gameStore().teamHot[record.team].score : 0),
+           (unsigned long)record.seq);
+  enqueuePointsUpdate(award);
+}
+
+void undoScore(const int count) {
+  int undone = undoScores(count > 0 ? count : 1, micros());
+  ESP_LOGI(BUMPER_TAG, "Undo %i/%i score awards", undone, count);
+  if (undone > 0) {
+    enqueueUndoUpdate(undone, scoreLedger().lastSeq);
+  }
 }
 
-void readyGame(const String question) {
-  ESP_LOGI(BUMPER_TAG, "Preparing game with question: %s", question.c_str());
+void readyGame(const char* question) {
+  ESP_LOGI(BUMPER_TAG, "Preparing game with question: %s", question);
 
 
-  if (isGameStopped() || isGamePrepare() || isGameReady()) {
+  if (canFirePhase(PhaseEvent::PREPARE)) {
  
-    setGamePhase("PREPARE");
-    if (question.toInt() > 0) {
+    if (atoi(question) > 0) {
       setCurrentQuestion(question);
       setQuestionStatus("AVAILABLE");
     } else {
@@ -209,39 +256,30 @@ void readyGame(const String question) {
     resetBumpersTime();
     resetBumpersReady();
     updateTeamsReady();
-    sendTeamsAndBumpers();
-
-    enqueueOutgoingMessage("PING", "{}", false, nullptr,"");
-    setLedByState(GameState::PREPARE);  
+    fireGamePhase(PhaseEvent::PREPARE);
   }
 }
 
 void RAZscores() {
   ESP_LOGI(BUMPER_TAG, "Resetting Bumpers Scores");
-  JsonObject bumpers = getBumpers();
-  if (!bumpers.isNull()) {
-        for (JsonPair kvp : bumpers) {
-            const char* key = kvp.key().c_str();
-            ESP_LOGI(BUMPER_TAG, "Resetting Score for %s", key);
-            setBumperScore(key, 0);
-            setBumperTime(key, -1);
-        }
-    } else {
-        ESP_LOGW(BUMPER_TAG, "Bumpers object is null or invalid");
+  for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+    if (gameStore().bumperUsed[slot]) {
+      ESP_LOGI(BUMPER_TAG, "Resetting Score for %s", bumperIdOf(slot));
+      gameStore().bumperHot[slot].score = 0;
+      markBumper(slot, BF_SCORE);
     }
+  }
   
   ESP_LOGI(BUMPER_TAG, "Resetting Teams Scores");
-  JsonObject teams = getTeams();
-    if (!teams.isNull()) {
-        for (JsonPair kvp : teams) {
-            const char* key = kvp.key().c_str();
-            ESP_LOGI(BUMPER_TAG, "Resetting Score for %s", key);
-            setTeamScore(key, 0);
-            setTeamTime(key, -1);
-        }
-    } else {
-        ESP_LOGW(BUMPER_TAG, "Teams object is null or invalid");
+  for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+    if (gameStore().teamUsed[slot]) {
+      ESP_LOGI(BUMPER_TAG, "Resetting Score for %s", teamIdOf(slot));
+      gameStore().teamHot[slot].score = 0;
+      markTeam(slot, TF_SCORE);
     }
+  }
+  startNewRound();
+  resetScoreLedger();
   ESP_LOGI(BUMPER_TAG, "Resetted Scores");
   notifyAll();
 }
@@ -254,15 +292,34 @@ void sendResetToAll() {
   enqueueOutgoingMessage("RESET", "{  }", true, nullptr,"");
 }
 
+//#### SUITES DIFFÉRÉES ###
+// Étape postée plus tard par un Ticker: la tâche de réception ne dort jamais. Une seule
+// suite en attente; la dernière programmée remplace la précédente (RESET: REBOOT remplace HELLO).
+#define FOLLOW_UP_DELAY_S 2.0
+Ticker followUpTicker;
+
+void postFollowUp(uint32_t type) {
+  postGameCommand((GameCommandType)type, 0);
+}
+
+void scheduleFollowUp(GameCommandType type) {
+  followUpTicker.once(FOLLOW_UP_DELAY_S, postFollowUp, (uint32_t)type);
+}
+
 void clearGame(bool notify=true) {
   ESP_LOGI(BUMPER_TAG, "clear Game");
-  if (LittleFS.exists(saveGameFile)) {
-    if (LittleFS.remove(saveGameFile)) {
-      ESP_LOGI(BUMPER_TAG, "Save file deleted successfully");
-    } else {
-      ESP_LOGE(BUMPER_TAG, "Error: Unable to delete save file");
+  cancelPendingSaves();
+  for (session_t session = 0; session < MAX_SESSIONS; session++) {
+    SessionScope scope(session);
+    String saveFile = sessionFile(saveGameFile);
+    if (LittleFS.exists(saveFile)) {
+      if (LittleFS.remove(saveFile)) {
+        ESP_LOGI(BUMPER_TAG, "Save file %s deleted successfully", saveFile.c_str());
+      } else {
+        ESP_LOGE(BUMPER_TAG, "Error: Unable to delete save file %s", saveFile.c_str());
+      }
     }
-  } 
+  }
   String dirToRemove = "/files";
   deleteDirectory(dirToRemove.c_str());
   ensureDirectoryExists(dirToRemove);
@@ -272,10 +329,20 @@ void clearGame(bool notify=true) {
   deleteDirectory(dirToRemove.c_str());
   dirToRemove = "/temp_parallel";
   deleteDirectory(dirToRemove.c_str());
-  loadJson(GameFile);
+  loadAllSessions();
   if (notify) {
-    sendResetToAll();
-    sleep(2);
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+      SessionScope scope(session);
+      sendResetToAll();
+    }
+    // Les buzzers redémarrent: HELLO une fois qu'ils écoutent de nouveau
+    scheduleFollowUp(GameCommandType::CLEAR_GAME_HELLO);
+  }
+}
+
+void helloAfterClear() {
+  for (session_t session = 0; session < MAX_SESSIONS; session++) {
+    SessionScope scope(session);
     sendHelloToAll();
     sendQuestions();
   }
@@ -284,14 +351,8 @@ void clearGame(bool notify=true) {
 void clearBuzzers() {
   ESP_LOGI(BUMPER_TAG, "clear Buzzers");
   RAZscores();
-  JsonObject bumpers = teamsAndBumpers["bumpers"];
-  for (JsonPair kvp : bumpers) {
-        bumpers.remove(kvp.key());
-      }
-  JsonObject teams = teamsAndBumpers["teams"];
-  for (JsonPair kvp : teams) {
-      teams.remove(kvp.key());
-    }
+  clearBumperSlots();
+  clearTeamSlots();
 
 }
 
@@ -304,13 +365,73 @@ void resetServer() {
 
 void rebootServer() {
   ESP_LOGI(BUMPER_TAG, "Rebooting server");
+  flushPendingSaves();
   setLedByState(GameState::ERROR);  
 //  setLedColor(255,16,16,true);
   ESP.restart();
 }
 
-void setRemotePage(const String remotePage) {
-  if (remotePage == nullptr || remotePage.isEmpty() || remotePage == "null") {
+//#### COMMANDES DE JEU ###
+// Exécutées par la tâche de réception, dans la session de la commande (gameActor.h)
+void applyGameCommand(const GameCommand& command) {
+  switch (command.type) {
+    case GameCommandType::TIMER_TICK:
+      // Un tick peut arriver juste après l'arrêt
+      if (isGameStarted()) {
+        updateTimer(getGameCurrentTime(), -1);
+      }
+      break;
+
+    case GameCommandType::BUTTON:
+      if (isGameStarted()) {
+        stopGame();
+      } else {
+        startGame();
+      }
+      break;
+
+    case GameCommandType::CLEAR_GAME:
+      clearGame();
+      break;
+
+    case GameCommandType::CLEAR_BUZZERS:
+      clearBuzzers();
+      requestSave();
+      break;
+
+    case GameCommandType::RESET:
+      // RESET aux buzzers, puis redémarrage une fois ce RESET diffusé
+      resetServer();
+      scheduleFollowUp(GameCommandType::REBOOT);
+      break;
+
+    case GameCommandType::REBOOT:
+      // Les commandes et messages qui précèdent sont appliqués et sauvés avant
+      rebootServer();
+      break;
+
+    case GameCommandType::BACKGROUND:
+      setBackgroundFile(command.arg);
+      requestSave();
+      enqueueOutgoingMessage("UPDATE", getGameJSON().c_str(), false, nullptr,"");
+      break;
+
+    case GameCommandType::RELOAD:
+      loadAllSessions();
+      break;
+
+    case GameCommandType::CLEAR_GAME_HELLO:
+      helloAfterClear();
+      break;
+
+    default:
+      ESP_LOGW(BUMPER_TAG, "Unknown game command %u", (unsigned)command.type);
+      break;
+  }
+}
+
+void setRemotePage(const char* remotePage) {
+  if (remotePage == nullptr || remotePage[0] == '\0' || strcmp(remotePage, "null") == 0) {
     setGamePage("GAME");
   } else {
     setGamePage(remotePage);
@@ -325,11 +446,9 @@ void handleHelloAction(const char* bumperID, JsonObject& MSG) {
 
 void handleButtonAction(const char* bumperID, JsonObject& MSG, AsyncClient* c) {
   ESP_LOGE(BUMPER_TAG, "Button pressed: %s", bumperID);
-  JsonObject bumper = getBumper(bumperID);
-  const char* teamID = bumper["TEAM"];
-  String b_button = MSG["button"];
-  if (teamID != nullptr) {
-    processButtonPress(bumperID, teamID, micros(), b_button);
+  slot_t slot = findBumperSlot(bumperID);
+  if (slot != NO_SLOT && gameStore().bumperHot[slot].team != NO_SLOT) {
+    processButtonPress(slot, micros(), MSG["button"] | "");
     pauseGame(c);
   }
 }
@@ -338,21 +457,69 @@ void handlePingResponseAction(const char* bumperID) {
     ESP_LOGI(BUMPER_TAG, "Bumper PONG received from: %s", bumperID);
     if (isGamePrepare()) {
         setBumperReady(bumperID);
-        updateTeamsReady();
         notifyAll();
         
         // Check if all teams are ready to potentially transition to READY state
         if (areAllTeamsReady()) {
             ESP_LOGI(BUMPER_TAG, "All teams are ready to start");
-            setGamePhase("READY");
-            enqueueOutgoingMessage("READY", getTeamsAndBumpersJSON().c_str(), true, nullptr,"");
-            setLedByState(GameState::READY);  
+            fireGamePhase(PhaseEvent::READY);
         }
     }
 }
 
-void deleteQuestion(const String ID) {
-  if (ID.toInt() > 0) {
+//#### SESSIONS ###
+// Indique au buzzer sa session: il ne retient ensuite que les broadcasts UDP de celle-ci
+void sendBumperSession(AsyncClient* client) {
+  if (client == nullptr) return;
+  char msg[24];
+  snprintf(msg, sizeof(msg), "{\"SESSION\": %u}", currentSession());
+  enqueueOutgoingMessage("SESSION", msg, false, client, "");
+}
+
+// Déplace un buzzer de la session courante vers une autre avec ses champs froids (NAME,
+// VERSION...), son IP et sa connexion. Équipe et score restent propres à l'ancienne session.
+bool moveBumperToSession(const char* bumperID, session_t to) {
+  session_t from = currentSession();
+  slot_t slot = findBumperSlot(bumperID);
+  if (to >= MAX_SESSIONS || to == from || slot == NO_SLOT) {
+    return false;
+  }
+  JsonDocument cold(taskJsonAllocator());
+  cold.set(bumperColdObj(slot));
+  char ip[sizeof(BumperCold::ip)];
+  copyFixed(ip, sizeof(ip), gameStore().bumperCold[slot].ip);
+  AsyncClient* client = gameStore().bumperClient[slot];
+  uint32_t connTag = gameStore().bumperConnTag[slot];
+  {
+    SessionScope scope(to);
+    slot_t target = allocBumperSlot(bumperID);
+    if (target == NO_SLOT) {
+      return false;
+    }
+    loadBumperFields(target, cold.as<JsonObjectConst>());
+    setBumperIPSlot(target, ip);
+    bindBumperClient(target, client, connTag);
+    requestFullSnapshot();
+    notifyAll();
+    requestSave();
+    sendBumperSession(client);
+  }
+  freeBumperSlot(slot);
+  requestFullSnapshot();
+  notifyAll();
+  ESP_LOGI(BUMPER_TAG, "Bumper %s moved from session %u to %u", bumperID, from, to);
+  return true;
+}
+
+// Mauvaise réponse: l'équipe suivante dans l'ordre des appuis prend la main
+void nextBuzzTurn() {
+  if (passBuzzTurn()) {
+    enqueueBuzzOrder();
+  }
+}
+
+void deleteQuestion(const char* ID) {
+  if (atoi(ID) > 0) {
     deleteDirectory((questionsPath + "/" + ID).c_str());
     sendQuestions();
   }
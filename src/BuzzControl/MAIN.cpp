@@ -94,8 +94,13 @@ sleep(5);
   //setLedColor(128, 128, 0, true);
   setLedByState(GameState::BOOT3);  
 
+  initGamePhaseHooks();
+  // Avant le bouton, le timer et le serveur web: ils ne font que poster des commandes
+  initGameCommands();
   attachButtons();
-  loadJson(GameFile);
+  initBuzzOrders();
+  initRankings();
+  loadAllSessions();
   setupAP();
 sleep(2);
   setupDNSServer();
@@ -109,17 +114,16 @@ sleep(2);
   initIncomingQueue();
   initOutgoingQueue();
 
+  // Avant l'écrivain: ses ajouts au journal des points prennent le verrou du fichier
+  startPersistTask(configManager.getSaveWindowMs());
+
   // Création des tâches pour traiter les messages
   xTaskCreate(receiveMessageTask, "Receive Message Task", 20480, NULL, 2, NULL);
   xTaskCreate(sendMessageTask, "Send Message Task", 20480, NULL, 2, NULL);
 
   // Création de la tâche pour surveiller le watchdog
   xTaskCreate( watchdogTask, "WatchdogTask", 2048, NULL, configMAX_PRIORITIES - 1, NULL );
-  
-  // Initialisation des mutex
-  questionMutex = xSemaphoreCreateMutex();
-  buttonMutex = xSemaphoreCreateMutex();
-  updateMutex = xSemaphoreCreateMutex();
+
   // Envoyer un message de bienvenue à tous les clients
   enqueueOutgoingMessage("HELLO", "{}", false, nullptr,"");
   setLedByState(GameState::READY);
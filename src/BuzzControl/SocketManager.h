@@ -8,63 +8,41 @@
 const char* SOCKET_TAG = "SOCKET";
 
 void handleWebSocketData(AsyncWebSocketClient *client, uint8_t *data, size_t len) {
-  IPAddress clientIP = client->remoteIP();
-  String ipStr = clientIP.toString();
-
-  ESP_LOGI(SOCKET_TAG, "Received WebSocket data from client %u (IP: %s)", client->id(), ipStr.c_str());
+  ESP_LOGI(SOCKET_TAG, "Received WebSocket data from client %u", client->id());
 
   if (len > 0) {
     // Limiter la taille des données loguées pour éviter de surcharger les logs
-    const size_t maxLogLength = 100;
-    size_t logLength = len < maxLogLength ? len : maxLogLength;
-
-    // Créer une copie temporaire des données pour s'assurer qu'elles sont null-terminées
-    char logBuffer[maxLogLength + 1];
-    memcpy(logBuffer, data, logLength);
-    logBuffer[logLength] = '\0';  // Ajouter un caractère nul à la fin
-
-    // Logger les données en tant que chaîne de caractères
-    ESP_LOGD(SOCKET_TAG, "Received WebSocket data from %s (first %u bytes): %s%s", ipStr.c_str(),
-             logLength, logBuffer, len > maxLogLength ? "..." : "");
+    const int maxLogLength = 100;
+    ESP_LOGD(SOCKET_TAG, "Received WebSocket data from client %u (first %u bytes): %.*s%s", client->id(),
+             len < maxLogLength ? len : maxLogLength, len < maxLogLength ? (int)len : maxLogLength,
+             (const char*)data, len > maxLogLength ? "..." : "");
   } else {
     ESP_LOGD(SOCKET_TAG, "Received empty WebSocket data");
     return;
   }
 
-  // Utiliser le même système de buffer que pour TCP
-  static std::map<String, String> wsClientBuffers;
-  String clientID = ipStr + "_" + String(client->id());
-  String partial_data = String((char*)data, len);
-  
-  // Ajouter les données au buffer du client
-  wsClientBuffers[clientID] += partial_data;
-  
-  // Traiter le buffer du client, à la recherche de messages JSON complets
-  String& jsonBuffer = wsClientBuffers[clientID];
-  int endOfJson;
-  
-  while ((endOfJson = jsonBuffer.indexOf('\0')) > 0) {
-    String jsonPart = jsonBuffer.substring(0, endOfJson);
-    jsonBuffer = jsonBuffer.substring(endOfJson + 1);
-    
-    // Envoyer le message JSON complet à la file d'attente
-    enqueueIncomingMessage("WebSocket", jsonPart.c_str(), nullptr);
-  }
+  // Trames copiées une fois dans l'anneau d'entrée
+  enqueueFrames(MessageSource::WEBSOCKET, NO_CONN, client->id(), data, len);
 }
 
 void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
-  IPAddress clientIP = client->remoteIP();
-  String ipStr = clientIP.toString();
-  
   switch(type) {
     case WS_EVT_CONNECT:
       // Quand un client se connecte, envoyer un message
-      ESP_LOGI(SOCKET_TAG, "WebSocket client %u IP: %s connected", client->id(), ipStr.c_str());
+      ESP_LOGI(SOCKET_TAG, "WebSocket client %u IP: %s connected", client->id(), client->remoteIP().toString().c_str());
+      // Session 0 jusqu'à son HELLO
+      lockWebClients();
+      registerWebClient(client->id());
+      unlockWebClients();
       break;
       
     case WS_EVT_DISCONNECT:
       // Quand un client se déconnecte
       ESP_LOGI(SOCKET_TAG, "WebSocket client %u disconnected", client->id());
+      lockWebClients();
+      unregisterWebClient(client->id());
+      forgetWebSocketBucket(client->id());
+      unlockWebClients();
       break;
       
     case WS_EVT_DATA:
@@ -87,30 +87,38 @@ void w_handleRedirect(AsyncWebServerRequest *request) {
     request->redirect("http://buzzcontrol.local/html/testSPA.html#config");
 }
 
+// Les handlers ne touchent pas l'état du jeu: ils postent une commande (gameActor.h)
+#define HTTP_COMMAND_WAIT pdMS_TO_TICKS(100)
+
 void w_handleReboot(AsyncWebServerRequest *request) {
     ESP_LOGI(WEB_TAG, "Handling reboot request");
     w_handleRedirect(request);
-    rebootServer();
+    postGameCommand(GameCommandType::REBOOT, 0, "", HTTP_COMMAND_WAIT);
 }
 
 void w_handleClearGame(AsyncWebServerRequest *request) {
     ESP_LOGI(WEB_TAG, "Handling Clear Game");
     w_handleRedirect(request);
-    clearGame();
+    postGameCommand(GameCommandType::CLEAR_GAME, 0, "", HTTP_COMMAND_WAIT);
+}
+
+// ?session=N: session visée par la requête, 0 par défaut
+session_t requestSession(AsyncWebServerRequest *request) {
+    if (!request->hasParam("session")) return 0;
+    session_t session = validSession(request->getParam("session")->value().toInt());
+    return session == NO_SESSION ? 0 : session;
 }
 
 void w_handleClearBuzzers(AsyncWebServerRequest *request) {
     ESP_LOGI(WEB_TAG, "Handling Clear Buzzers");
     w_handleRedirect(request);
-    clearBuzzers();
+    postGameCommand(GameCommandType::CLEAR_BUZZERS, requestSession(request), "", HTTP_COMMAND_WAIT);
 }
 
 void w_handleReset(AsyncWebServerRequest *request) {
     ESP_LOGI(WEB_TAG, "Handling reset request");
     w_handleRedirect(request);
-    clearGame();
-    resetServer();
-    rebootServer();
+    postGameCommand(GameCommandType::RESET, 0, "", HTTP_COMMAND_WAIT);
 }
 
 void w_handleListFiles(AsyncWebServerRequest *request) {
@@ -129,8 +137,42 @@ void w_handleUpdate(AsyncWebServerRequest *request) {
 }
 
 void w_handleListGame(AsyncWebServerRequest *request) {
+    SessionScope scope(requestSession(request));
+    String result;
+    result=getPublishedStateJSON();
+    request->send(200, "text/json", result);
+}
+
+void w_handleRanking(AsyncWebServerRequest *request) {
+    SessionScope scope(requestSession(request));
+    request->send(200, "text/json", getPublishedRankingJSON());
+}
+
+void w_handleBuzzOrder(AsyncWebServerRequest *request) {
+    SessionScope scope(requestSession(request));
+    request->send(200, "text/json", getPublishedBuzzOrderJSON());
+}
+
+void w_handleMemory(AsyncWebServerRequest *request) {
+    SessionScope scope(requestSession(request));
+    JsonDocument doc;
+    writePoolStats(doc.to<JsonObject>());
+    writeAllocProbeStats(doc["BUZZ_PATH"].to<JsonObject>());
+    writeSessionStats(doc["SESSIONS"].to<JsonArray>());
+    writeIncomingStats(doc["INCOMING"].to<JsonObject>());
+    writeAdmissionStats(doc["ADMISSION"].to<JsonObject>());
+    writePersistStats(doc["PERSIST"].to<JsonArray>());
+    writeEncoderStats(doc["ENCODER"].to<JsonObject>());
+    String result;
+    serializeJson(doc, result);
+    request->send(200, "text/json", result);
+}
+
+void w_handleMetrics(AsyncWebServerRequest *request) {
+    JsonDocument doc;
+    writeMetrics(doc.to<JsonObject>());
     String result;
-    result=getTeamsAndBumpersJSON();
+    serializeJson(doc, result);
     request->send(200, "text/json", result);
 }
 
@@ -181,9 +223,7 @@ void w_handleUploadBackgroundFile(AsyncWebServerRequest *request, String filenam
     saveFile(request, filePath,  filename,  index,  data,  len,  final);
     if(final) { // Fin de l'upload
         ESP_LOGI(WEB_TAG, "Upload du fichier Config terminé");
-        setBackgroundFile(filePath);
-        saveJson();
-        enqueueOutgoingMessage("UPDATE", getGameJSON().c_str(), false, nullptr,"");
+        postGameCommand(GameCommandType::BACKGROUND, requestSession(request), filePath.c_str(), HTTP_COMMAND_WAIT);
     }
 }
 
@@ -256,7 +296,7 @@ String saveQuestion(AsyncWebServerRequest *request, String fileName = "") {
         jsonFile.close();
     }
 */
-    writeQuestion(currentDir,jsonString);
+    writeQuestion(currentDir.c_str(), jsonString);
     return currentDir;
 }
 
@@ -593,7 +633,7 @@ void handleFSRestore(AsyncWebServerRequest *request, String filename,
         if (success) {
             ESP_LOGI(WEB_TAG, "FS Restore terminé avec succès, rechargement de la configuration");
             // Recharger les données après restauration
-            loadJson(GameFile);
+            postGameCommand(GameCommandType::RELOAD, 0, "", HTTP_COMMAND_WAIT);
             configManager.load();
         }
     }
@@ -661,6 +701,10 @@ void startWebServer() {
     server.on("/update", HTTP_GET, w_handleUpdate);
     server.on("/listFiles",HTTP_GET, w_handleListFiles);
     server.on("/listGame",HTTP_GET, w_handleListGame);
+    server.on("/ranking",HTTP_GET, w_handleRanking);
+    server.on("/buzzOrder",HTTP_GET, w_handleBuzzOrder);
+    server.on("/memory",HTTP_GET, w_handleMemory);
+    server.on("/metrics",HTTP_GET, w_handleMetrics);
 
     server.on("/fs-backup", HTTP_GET, handleFSBackup);
     server.on("/game-backup", HTTP_GET, handleGameBackup);
@@ -679,6 +723,7 @@ void startWebServer() {
     server.on("/questions", HTTP_POST, w_handleUploadQuestionComplete, w_handleUploadQuestionFile);
     server.on("/questions", HTTP_GET, w_handleListQuestions);
 
+    webClientsLock = xSemaphoreCreateMutex();
     ws.onEvent(onWsEvent);
     server.addHandler(&ws);
 
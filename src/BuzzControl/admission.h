@@ -0,0 +1,124 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "session.h"
+
+#include <ArduinoJson.h>
+
+static const char* ADMISSION_TAG = "ADMISSION";
+
+// Contrôle d'admission des trames entrantes, appliqué dans les callbacks réseau (async_tcp)
+// avant toute copie: un seau à jetons par source (connexion buzzer, client WebSocket).
+// Une trame temps réel coûte un jeton; une trame de fond exige en plus une réserve, elle est
+// donc écartée la première quand une source s'emballe. Rien ne bloque ni n'attend.
+#ifndef ADMIT_TCP_RATE
+#define ADMIT_TCP_RATE 20       // trames/s par connexion buzzer
+#endif
+#ifndef ADMIT_TCP_BURST
+#define ADMIT_TCP_BURST 10
+#endif
+#ifndef ADMIT_WS_RATE
+#define ADMIT_WS_RATE 50        // trames/s par client WebSocket
+#endif
+#ifndef ADMIT_WS_BURST
+#define ADMIT_WS_BURST 40
+#endif
+#define ADMIT_BULK_RESERVE 2    // jetons gardés pour le temps réel
+#define TOKEN 1000              // jetons en millièmes
+
+struct TokenBucket {
+    uint32_t tokens;        // millièmes de jeton
+    uint32_t refilledAt;    // millis()
+    bool throttling;        // épisode de rejet en cours (un seul log par épisode)
+    uint32_t admitted;
+    uint32_t throttled;
+};
+
+void resetBucket(TokenBucket& bucket, uint32_t burst) {
+    bucket.tokens = burst * TOKEN;
+    bucket.refilledAt = millis();
+    bucket.throttling = false;
+    bucket.admitted = 0;
+    bucket.throttled = 0;
+}
+
+// rate jetons/s = rate millièmes par ms
+bool takeToken(TokenBucket& bucket, uint32_t rate, uint32_t burst, bool realtime) {
+    uint32_t now = millis();
+    uint64_t tokens = bucket.tokens + (uint64_t)(now - bucket.refilledAt) * rate;
+    bucket.tokens = tokens > burst * TOKEN ? burst * TOKEN : (uint32_t)tokens;
+    bucket.refilledAt = now;
+
+    uint32_t need = realtime ? TOKEN : TOKEN * (1 + ADMIT_BULK_RESERVE);
+    if (bucket.tokens < need) {
+        bucket.throttled++;
+        return false;
+    }
+    bucket.tokens -= TOKEN;
+    bucket.admitted++;
+    return true;
+}
+
+//#### CLIENTS WEBSOCKET ###
+// Seaux des clients WebSocket, indexés par id; touchés seulement depuis async_tcp
+struct WebSocketBucket {
+    uint32_t id;            // 0 = libre
+    TokenBucket bucket;
+};
+
+WebSocketBucket wsBuckets[MAX_WEB_CLIENTS];
+uint32_t wsUntracked = 0;   // trames de clients hors table, admises sans limite
+
+// nullptr si la table est pleine
+TokenBucket* webSocketBucket(uint32_t id) {
+    WebSocketBucket* spare = nullptr;
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (wsBuckets[i].id == id) return &wsBuckets[i].bucket;
+        if (wsBuckets[i].id == 0 && spare == nullptr) spare = &wsBuckets[i];
+    }
+    if (spare == nullptr) return nullptr;
+    spare->id = id;
+    resetBucket(spare->bucket, ADMIT_WS_BURST);
+    return &spare->bucket;
+}
+
+void forgetWebSocketBucket(uint32_t id) {
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (wsBuckets[i].id == id) wsBuckets[i].id = 0;
+    }
+}
+
+// Log à l'entrée et à la sortie d'un épisode de rejet, pas à chaque trame
+void logThrottle(TokenBucket& bucket, bool admitted, const char* kind, uint32_t id) {
+    if (!admitted && !bucket.throttling) {
+        ESP_LOGW(ADMISSION_TAG, "%s %u over its rate, shedding frames", kind, id);
+    } else if (admitted && bucket.throttling) {
+        ESP_LOGI(ADMISSION_TAG, "%s %u back under its rate (%u frames shed so far)", kind, id, bucket.throttled);
+    }
+    bucket.throttling = !admitted;
+}
+
+bool admitWebSocketFrame(uint32_t id, bool realtime) {
+    TokenBucket* bucket = webSocketBucket(id);
+    if (bucket == nullptr) {
+        wsUntracked++;
+        return true;
+    }
+    bool admitted = takeToken(*bucket, ADMIT_WS_RATE, ADMIT_WS_BURST, realtime);
+    logThrottle(*bucket, admitted, "WebSocket client", id);
+    return admitted;
+}
+
+void writeWebSocketAdmission(JsonObject dst) {
+    dst["RATE"] = ADMIT_WS_RATE;
+    dst["BURST"] = ADMIT_WS_BURST;
+    dst["UNTRACKED"] = wsUntracked;
+    JsonArray clients = dst["CLIENTS"].to<JsonArray>();
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        const WebSocketBucket& entry = wsBuckets[i];
+        if (entry.id == 0) continue;
+        JsonObject obj = clients.add<JsonObject>();
+        obj["ID"] = entry.id;
+        obj["ADMITTED"] = entry.bucket.admitted;
+        obj["THROTTLED"] = entry.bucket.throttled;
+    }
+}
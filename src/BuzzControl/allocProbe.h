@@ -0,0 +1,115 @@
+#pragma once
+#include "Common/CustomLogger.h"
+
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const char* ALLOC_TAG = "ALLOC_PROBE";
+
+// Compteur d'allocations du chemin d'un appui (trame BUTTON -> mise en file de la diffusion).
+// Actif seulement dans l'environnement buzzcontrol_allocprobe, qui enveloppe malloc/calloc/
+// realloc à l'édition de liens; sinon les appels se réduisent à rien.
+struct AllocProbeStats {
+    uint32_t windows;       // fenêtres mesurées
+    uint32_t dirty;         // fenêtres avec au moins une allocation
+    uint32_t last;          // allocations de la dernière fenêtre
+    uint32_t worst;
+};
+
+AllocProbeStats allocProbeStats;
+
+#ifdef ALLOC_PROBE
+
+static TaskHandle_t allocProbeTask = nullptr;
+static volatile uint32_t allocProbeCount = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static inline void countAllocation() {
+    if (allocProbeTask != nullptr && xTaskGetCurrentTaskHandle() == allocProbeTask) {
+        allocProbeCount++;
+    }
+}
+
+void* __wrap_malloc(size_t size) {
+    countAllocation();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    countAllocation();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    countAllocation();
+    return __real_realloc(ptr, size);
+}
+}
+
+// Ouvre une fenêtre de mesure pour la tâche courante
+void allocProbeBegin() {
+    allocProbeCount = 0;
+    allocProbeTask = xTaskGetCurrentTaskHandle();
+}
+
+// Ferme la fenêtre et retourne le nombre d'allocations observées
+uint32_t allocProbeEnd(const char* what) {
+    if (allocProbeTask == nullptr) return 0;
+    allocProbeTask = nullptr;
+    uint32_t count = allocProbeCount;
+    allocProbeStats.windows++;
+    allocProbeStats.last = count;
+    if (count > 0) {
+        allocProbeStats.dirty++;
+        if (count > allocProbeStats.worst) allocProbeStats.worst = count;
+        ESP_LOGW(ALLOC_TAG, "%s: %u heap allocations", what, count);
+    }
+    return count;
+}
+
+// Fenêtre abandonnée sans être comptée (trame qui n'est pas un appui)
+void allocProbeDiscard() {
+    allocProbeTask = nullptr;
+}
+
+#else
+
+void allocProbeBegin() {}
+uint32_t allocProbeEnd(const char* what) { return 0; }
+void allocProbeDiscard() {}
+
+#endif
+
+// Fenêtre ouverte pour toute la portée: fermée à la sortie, quel que soit le chemin. Comptée
+// seulement si measure() a nommé le chemin, abandonnée sinon.
+class AllocProbeScope {
+public:
+    AllocProbeScope() { allocProbeBegin(); }
+    ~AllocProbeScope() {
+        if (what_ != nullptr) allocProbeEnd(what_);
+        else allocProbeDiscard();
+    }
+    AllocProbeScope(const AllocProbeScope&) = delete;
+    AllocProbeScope& operator=(const AllocProbeScope&) = delete;
+
+    void measure(const char* what) { what_ = what; }
+
+private:
+    const char* what_ = nullptr;
+};
+
+void writeAllocProbeStats(JsonObject dst) {
+#ifdef ALLOC_PROBE
+    dst["WINDOWS"] = allocProbeStats.windows;
+    dst["DIRTY"] = allocProbeStats.dirty;
+    dst["LAST"] = allocProbeStats.last;
+    dst["WORST"] = allocProbeStats.worst;
+#else
+    dst["ENABLED"] = false;
+#endif
+}
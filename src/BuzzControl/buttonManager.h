@@ -5,18 +5,15 @@
 
 static const char* BUTTON_TAG = "BUTTON_MANAGER";
 
+// Contexte d'interruption: rien n'est modifié ici, la commande part à la tâche de réception
 static void IRAM_ATTR buttonHandler(void *arg) {
     ButtonInfo* buttonInfo = static_cast<ButtonInfo*>(arg);
     switch(buttonInfo->pin) {
         case 0:
-            if (GameStarted) {
-                stopGame();
-            } else {
-                startGame();
-            }
+            // Le bouton du contrôleur pilote la session 0
+            postGameCommandFromISR(GameCommandType::BUTTON, 0);
             break;
         default:
-            ESP_LOGW(BUTTON_TAG, "Unknown button pin: %d", buttonInfo->pin);
             break;
     }
 }
@@ -0,0 +1,176 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "Common/jsonArena.h"
+#include "gameStore.h"
+#include "publishedText.h"
+
+#include <ArduinoJson.h>
+
+static const char* BUZZ_ORDER_TAG = "BUZZ_ORDER";
+
+// Ordre global des appuis de la manche: chaque appui est inséré à sa place, trié par
+// timestamp puis slot puis ordre d'arrivée (égalités départagées de façon déterministe).
+#define BUZZ_ORDER_CAPACITY 64
+#define BUZZ_ORDER_TEXT_RESERVE 1024
+
+struct BuzzPress {
+    int64_t timestamp;
+    uint16_t arrival;       // numéro d'arrivée dans la manche
+    slot_t bumper;
+    slot_t team;
+    char button[8];
+};
+
+struct BuzzOrder {
+    BuzzPress presses[BUZZ_ORDER_CAPACITY];
+    uint8_t count;
+    uint16_t arrivals;      // appuis reçus, y compris ceux écartés quand la table est pleine
+    slot_t teams[MAX_TEAMS];  // équipes dans l'ordre de leur premier appui
+    uint8_t teamCount;
+    // Équipe qui a la main une fois passée (NO_SLOT: la première de l'ordre). Retenue par son
+    // slot: un appui plus ancien arrivé en retard décale les positions, pas la main.
+    slot_t turnTeam = NO_SLOT;
+    uint8_t current;        // position de turnTeam dans teams, recalculée à chaque reconstruction
+    uint32_t revision;
+    uint32_t publishedRevision;
+    // Dernier ordre diffusé, lu sans verrou par /buzzOrder
+    PublishedText published;
+};
+
+// Un ordre des appuis par session
+BuzzOrder buzzOrders[MAX_SESSIONS];
+
+inline BuzzOrder& buzzOrder() {
+    return buzzOrders[currentSession()];
+}
+
+// Au démarrage: tampons de publication réservés, un appui ne les agrandit pas
+void initBuzzOrders() {
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        reservePublishedText(buzzOrders[session].published, BUZZ_ORDER_TEXT_RESERVE);
+    }
+}
+
+bool buzzPressBefore(const BuzzPress& a, const BuzzPress& b) {
+    if (a.timestamp != b.timestamp) return a.timestamp < b.timestamp;
+    if (a.bumper != b.bumper) return a.bumper < b.bumper;
+    return a.arrival < b.arrival;
+}
+
+// Remise à zéro en début de manche
+void resetBuzzOrder() {
+    buzzOrder().count = 0;
+    buzzOrder().arrivals = 0;
+    buzzOrder().teamCount = 0;
+    buzzOrder().turnTeam = NO_SLOT;
+    buzzOrder().current = 0;
+    buzzOrder().revision++;
+}
+
+// Équipes par premier appui: reconstruit depuis la liste triée (au plus MAX_TEAMS entrées)
+void rebuildBuzzTeams() {
+    bool seen[MAX_TEAMS] = {};
+    buzzOrder().teamCount = 0;
+    for (uint8_t i = 0; i < buzzOrder().count && buzzOrder().teamCount < MAX_TEAMS; i++) {
+        slot_t team = buzzOrder().presses[i].team;
+        if (team < MAX_TEAMS && !seen[team]) {
+            seen[team] = true;
+            buzzOrder().teams[buzzOrder().teamCount++] = team;
+        }
+    }
+    buzzOrder().current = 0;
+    if (buzzOrder().turnTeam == NO_SLOT) return;
+    for (uint8_t i = 0; i < buzzOrder().teamCount; i++) {
+        if (buzzOrder().teams[i] == buzzOrder().turnTeam) {
+            buzzOrder().current = i;
+            return;
+        }
+    }
+    // Équipe sortie de la table pleine: la main reste en fin d'ordre
+    buzzOrder().current = buzzOrder().teamCount > 0 ? buzzOrder().teamCount - 1 : 0;
+}
+
+// Retourne la position de l'appui dans l'ordre, -1 s'il arrive trop tard pour la table pleine
+int recordBuzzPress(slot_t bumper, slot_t team, int64_t timestamp, const char* button) {
+    BuzzPress press = {};
+    press.timestamp = timestamp;
+    press.arrival = buzzOrder().arrivals++;
+    press.bumper = bumper;
+    press.team = team;
+    copyFixed(press.button, sizeof(press.button), button);
+
+    uint8_t lo = 0, hi = buzzOrder().count;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (buzzPressBefore(buzzOrder().presses[mid], press)) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo >= BUZZ_ORDER_CAPACITY) {
+        ESP_LOGW(BUZZ_ORDER_TAG, "Buzz order full, press from %s dropped", bumperIdOf(bumper));
+        return -1;
+    }
+    // Table pleine: le dernier appui est écarté au profit du nouveau
+    uint8_t moved = (buzzOrder().count < BUZZ_ORDER_CAPACITY ? buzzOrder().count : BUZZ_ORDER_CAPACITY - 1) - lo;
+    memmove(&buzzOrder().presses[lo + 1], &buzzOrder().presses[lo], moved * sizeof(BuzzPress));
+    buzzOrder().presses[lo] = press;
+    if (buzzOrder().count < BUZZ_ORDER_CAPACITY) buzzOrder().count++;
+    rebuildBuzzTeams();
+    buzzOrder().revision++;
+    ESP_LOGD(BUZZ_ORDER_TAG, "Press %s@%s at %lld => position %u/%u", button, bumperIdOf(bumper), timestamp, lo + 1, buzzOrder().count);
+    return lo;
+}
+
+// Mauvaise réponse: la main passe à l'équipe suivante dans l'ordre des appuis
+bool passBuzzTurn() {
+    if (buzzOrder().current + 1 >= buzzOrder().teamCount) {
+        ESP_LOGI(BUZZ_ORDER_TAG, "No next team in buzz order");
+        return false;
+    }
+    buzzOrder().current++;
+    buzzOrder().turnTeam = buzzOrder().teams[buzzOrder().current];
+    buzzOrder().revision++;
+    ESP_LOGI(BUZZ_ORDER_TAG, "Turn passed to team %s", teamIdOf(buzzOrder().teams[buzzOrder().current]));
+    return true;
+}
+
+bool isBuzzOrderChanged() {
+    return buzzOrder().revision != buzzOrder().publishedRevision;
+}
+
+// Construit et publie l'ordre courant (côté écrivain). Le texte retourné reste valable
+// jusqu'à la publication suivante: à recopier aussitôt.
+const String& publishBuzzOrder() {
+    JsonDocument doc(taskJsonAllocator());
+    int64_t first = buzzOrder().count > 0 ? buzzOrder().presses[0].timestamp : 0;
+    JsonArray presses = doc["presses"].to<JsonArray>();
+    for (uint8_t i = 0; i < buzzOrder().count; i++) {
+        const BuzzPress& press = buzzOrder().presses[i];
+        JsonObject entry = presses.add<JsonObject>();
+        entry["RANK"] = i + 1;
+        entry["BUMPER"] = (const char*)gameStore().bumperCold[press.bumper].id;
+        if (press.team < MAX_TEAMS) entry["TEAM"] = (const char*)gameStore().teamCold[press.team].id;
+        entry["BUTTON"] = (const char*)press.button;
+        entry["TIMESTAMP"] = press.timestamp;
+        entry["DELAY"] = press.timestamp - first;   // µs après le premier appui
+    }
+    JsonArray teams = doc["teams"].to<JsonArray>();
+    for (uint8_t i = 0; i < buzzOrder().teamCount; i++) {
+        teams.add((const char*)gameStore().teamCold[buzzOrder().teams[i]].id);
+    }
+    if (buzzOrder().teamCount > 0) {
+        doc["CURRENT"] = (const char*)gameStore().teamCold[buzzOrder().teams[buzzOrder().current]].id;
+    }
+    doc["DROPPED"] = buzzOrder().arrivals - buzzOrder().count;
+    buzzOrder().publishedRevision = buzzOrder().revision;
+
+    int8_t index = claimPublishedText(buzzOrder().published);
+    String& output = publishedTextBuffer(buzzOrder().published, index);
+    serializeJson(doc, output);
+    commitPublishedText(buzzOrder().published, index);
+    return output;
+}
+
+// /buzzOrder: dernier ordre publié
+String getPublishedBuzzOrderJSON() {
+    return readPublishedText(buzzOrder().published, "{}");
+}
@@ -1733,14 +1733,16 @@ String listLittleFSFiles(String path) {
 
 
 
+// Charge la session courante: sa sauvegarde, sinon le jeu de départ commun
 void loadJson(String path) {
     File file;
-    String output;
-    ESP_LOGI(FS_TAG, "Loading game file");
+    JsonDocument doc;
+    String saveFile = sessionFile(saveGameFile);
+    ESP_LOGI(FS_TAG, "Loading game file for session %u", currentSession());
     
-    if (LittleFS.exists(saveGameFile)) {
-        file = LittleFS.open(saveGameFile, "r");
-        ESP_LOGI(FS_TAG, "Loading from save file: %s", saveGameFile);
+    if (LittleFS.exists(saveFile)) {
+        file = LittleFS.open(saveFile, "r");
+        ESP_LOGI(FS_TAG, "Loading from save file: %s", saveFile.c_str());
     } else if (LittleFS.exists(GameFile)) {
         file = LittleFS.open(GameFile, "r");
         ESP_LOGI(FS_TAG, "Loading from game file: %s", GameFile);
@@ -1748,38 +1750,35 @@ void loadJson(String path) {
 
     if (!file) {
         ESP_LOGE(FS_TAG, "Failed to open file for reading. Initializing with default values.");
-        setBumpers(JsonObject());
-        setTeams(JsonObject());
+        loadStore(JsonObjectConst());
+        replayScoreLedger(JsonObjectConst());
+        publishRanking();
         return;
     }
 
-    DeserializationError error = deserializeJson(teamsAndBumpers, file);
+    DeserializationError error = deserializeJson(doc, file);
     if (error) {
         ESP_LOGE(FS_TAG, "deserializeJson() failed: %s", error.c_str());
-        setBumpers( JsonObject());
-        setTeams( JsonObject());
+        loadStore(JsonObjectConst());
+        replayScoreLedger(JsonObjectConst());
     } else {
+        loadStore(doc.as<JsonObjectConst>());
+        replayScoreLedger(doc["LEDGER"].as<JsonObjectConst>());
         ESP_LOGI(FS_TAG, "JSON loaded successfully");
     }
 
     file.close();
-    serializeJson(teamsAndBumpers, output);
-    ESP_LOGI(FS_TAG, "JSON loaded: %s", output.c_str());
+    publishRanking();
+    ESP_LOGI(FS_TAG, "JSON loaded: %s", getTeamsAndBumpersJSON().c_str());
 }
 
-void saveJson() {
-    File file = LittleFS.open(saveGameFile, "w");
-    if (!file) {
-        ESP_LOGE(FS_TAG, "Failed to open file for writing");
-        return;
-    }
-
-    if (serializeJson(teamsAndBumpers, file) == 0) {
-        ESP_LOGE(FS_TAG, "Failed to write to file");
+void loadAllSessions() {
+    // Une sauvegarde différée de l'ancien état ne doit pas écraser celui qu'on recharge
+    cancelPendingSaves();
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        SessionScope scope(session);
+        loadJson(GameFile);
     }
-
-    file.close();
-    ESP_LOGI(FS_TAG, "JSON saved successfully");
 }
 
 void downloadFiles() {
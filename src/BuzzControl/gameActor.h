@@ -0,0 +1,114 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "session.h"
+
+#include <ArduinoJson.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+static const char* ACTOR_TAG = "GAME_ACTOR";
+
+// La tâche de réception est l'unique écrivain de l'état du jeu. Les autres contextes (timer,
+// bouton du contrôleur, handlers HTTP) ne modifient rien: ils postent une commande, exécutée
+// par cette tâche entre les messages temps réel et ceux de fond, et lisent les snapshots.
+#define GAME_COMMAND_SLOTS 16
+#define GAME_COMMAND_ARG 48     // "/files/background_NNNN.jpg" et marge; plus long: refusé
+
+enum class GameCommandType : uint8_t {
+    TIMER_TICK,     // seconde écoulée du décompte (Ticker)
+    BUTTON,         // bouton du contrôleur: START ou STOP (ISR)
+    CLEAR_GAME,
+    CLEAR_BUZZERS,
+    RESET,
+    REBOOT,
+    BACKGROUND,     // arg: chemin du fond d'écran déjà écrit
+    RELOAD,         // recharge des sauvegardes (restauration)
+    CLEAR_GAME_HELLO, // suite de CLEAR_GAME: HELLO et questions, après le RESET des buzzers
+    COUNT
+};
+
+// Noms des mesures par commande (pipelineMetrics.h), distincts des actions reçues
+const char* gameCommandName(GameCommandType type) {
+    static const char* names[(uint8_t)GameCommandType::COUNT] = {
+        "@TIMER_TICK", "@BUTTON", "@CLEAR_GAME", "@CLEAR_BUZZERS", "@RESET", "@REBOOT", "@BACKGROUND", "@RELOAD",
+        "@CLEAR_GAME_HELLO"
+    };
+    return type < GameCommandType::COUNT ? names[(uint8_t)type] : "@?";
+}
+
+// Copiée par valeur dans la file: aucune allocation, postable depuis une ISR
+struct GameCommand {
+    GameCommandType type;
+    session_t session;
+    int64_t postedAt;
+    char arg[GAME_COMMAND_ARG];
+};
+
+QueueHandle_t gameCommands = NULL;
+// Réveil partagé avec les anneaux entrants (messages_received.h)
+extern SemaphoreHandle_t incomingReady;
+// Incrémentés depuis plusieurs tâches et l'ISR du bouton
+std::atomic<uint32_t> gameCommandsPosted{0};
+std::atomic<uint32_t> gameCommandsDropped{0};
+std::atomic<UBaseType_t> gameCommandsPeak{0};
+
+void initGameCommands() {
+    gameCommands = xQueueCreate(GAME_COMMAND_SLOTS, sizeof(GameCommand));
+    if (gameCommands == NULL) {
+        ESP_LOGE(ACTOR_TAG, "Failed to create game command queue");
+    }
+}
+
+// wait: 0 depuis le timer, quelques ms depuis un handler HTTP qui ne doit pas perdre sa commande
+bool postGameCommand(GameCommandType type, session_t session, const char* arg = "", TickType_t wait = 0) {
+    // Argument tronqué = chemin faux: refusé plutôt qu'exécuté
+    if (strlen(arg) >= GAME_COMMAND_ARG) {
+        gameCommandsDropped++;
+        ESP_LOGE(ACTOR_TAG, "Game command %s dropped, arg too long (%u >= %u): %s",
+                 gameCommandName(type), strlen(arg), GAME_COMMAND_ARG, arg);
+        return false;
+    }
+    GameCommand command;
+    command.type = type;
+    command.session = session;
+    command.postedAt = micros();
+    strlcpy(command.arg, arg, sizeof(command.arg));
+    if (gameCommands == NULL || xQueueSend(gameCommands, &command, wait) != pdPASS) {
+        gameCommandsDropped++;
+        ESP_LOGE(ACTOR_TAG, "Game command %s dropped, queue full", gameCommandName(type));
+        return false;
+    }
+    gameCommandsPosted++;
+    UBaseType_t depth = uxQueueMessagesWaiting(gameCommands);
+    UBaseType_t peak = gameCommandsPeak;
+    while (depth > peak && !gameCommandsPeak.compare_exchange_weak(peak, depth)) {}
+    // Avant le démarrage de la tâche de réception, la commande attend son premier réveil
+    if (incomingReady != NULL) xSemaphoreGive(incomingReady);
+    return true;
+}
+
+// Depuis une ISR: ni log ni horodatage esp_timer
+void IRAM_ATTR postGameCommandFromISR(GameCommandType type, session_t session) {
+    if (gameCommands == NULL) return;
+    GameCommand command;
+    command.type = type;
+    command.session = session;
+    command.postedAt = 0;
+    command.arg[0] = '\0';
+    BaseType_t woken = pdFALSE;
+    if (xQueueSendFromISR(gameCommands, &command, &woken) == pdPASS) {
+        if (incomingReady != NULL) xSemaphoreGiveFromISR(incomingReady, &woken);
+    } else {
+        gameCommandsDropped++;
+    }
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void writeGameCommandStats(JsonObject dst) {
+    dst["DEPTH"] = gameCommands != NULL ? uxQueueMessagesWaiting(gameCommands) : 0;
+    dst["DEPTH_PEAK"] = gameCommandsPeak.load();
+    dst["POSTED"] = gameCommandsPosted.load();
+    dst["DROPPED"] = gameCommandsDropped.load();
+}
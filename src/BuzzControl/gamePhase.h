@@ -0,0 +1,115 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "session.h"
+#include <atomic>
+
+static const char* PHASE_TAG = "GAME_PHASE";
+
+// Phases publiées dans GAME.PHASE
+enum class GamePhase : uint8_t { STOP, PREPARE, READY, START, PAUSE, COUNT, INVALID = 0xFF };
+
+// Commandes de jeu qui font évoluer la phase
+enum class PhaseEvent : uint8_t { PREPARE, READY, START, PAUSE, CONTINUE, STOP, REVEAL, COUNT };
+
+constexpr uint8_t PHASE_COUNT = (uint8_t)GamePhase::COUNT;
+constexpr uint8_t PHASE_EVENT_COUNT = (uint8_t)PhaseEvent::COUNT;
+
+constexpr const char* gamePhaseNames[PHASE_COUNT] = { "STOP", "PREPARE", "READY", "START", "PAUSE" };
+constexpr const char* phaseEventNames[PHASE_EVENT_COUNT] = { "PREPARE", "READY", "START", "PAUSE", "CONTINUE", "STOP", "REVEAL" };
+
+// Table de transitions: [phase courante][commande] => phase cible, INVALID si refusée.
+// REVEAL ne quitte pas STOP: c'est une transition STOP->STOP qui déclenche ses propres hooks.
+constexpr GamePhase X_ = GamePhase::INVALID;
+constexpr GamePhase phaseTransitions[PHASE_COUNT][PHASE_EVENT_COUNT] = {
+    //               PREPARE             READY            START             PAUSE             CONTINUE          STOP             REVEAL
+    /* STOP    */  { GamePhase::PREPARE, X_,              GamePhase::START, X_,               X_,               GamePhase::STOP, GamePhase::STOP },
+    /* PREPARE */  { GamePhase::PREPARE, GamePhase::READY, GamePhase::START, X_,              X_,               GamePhase::STOP, X_ },
+    /* READY   */  { GamePhase::PREPARE, X_,              GamePhase::START, X_,               X_,               GamePhase::STOP, X_ },
+    /* START   */  { X_,                 X_,              X_,               GamePhase::PAUSE, X_,               GamePhase::STOP, X_ },
+    /* PAUSE   */  { X_,                 X_,              X_,               X_,               GamePhase::START, GamePhase::STOP, X_ },
+};
+
+static_assert(phaseTransitions[(uint8_t)GamePhase::START][(uint8_t)PhaseEvent::PAUSE] == GamePhase::PAUSE, "START -> PAUSE");
+static_assert(phaseTransitions[(uint8_t)GamePhase::PAUSE][(uint8_t)PhaseEvent::CONTINUE] == GamePhase::START, "PAUSE -> START");
+static_assert(phaseTransitions[(uint8_t)GamePhase::STOP][(uint8_t)PhaseEvent::REVEAL] == GamePhase::STOP, "REVEAL stays in STOP");
+
+constexpr GamePhase nextGamePhase(GamePhase from, PhaseEvent event) {
+    return ((uint8_t)from < PHASE_COUNT && (uint8_t)event < PHASE_EVENT_COUNT)
+        ? phaseTransitions[(uint8_t)from][(uint8_t)event]
+        : GamePhase::INVALID;
+}
+
+// Phase de chaque session (STOP = 0 au démarrage): lecture sans verrou depuis le timer,
+// les tâches, les handlers HTTP et l'ISR
+std::atomic<GamePhase> sessionPhases[MAX_SESSIONS];
+
+inline std::atomic<GamePhase>& currentGamePhase() {
+    return sessionPhases[currentSession()];
+}
+
+inline GamePhase getPhase() {
+    return currentGamePhase().load(std::memory_order_acquire);
+}
+
+inline const char* gamePhaseName(GamePhase phase) {
+    return (uint8_t)phase < PHASE_COUNT ? gamePhaseNames[(uint8_t)phase] : "UNKNOWN";
+}
+
+inline const char* phaseEventName(PhaseEvent event) {
+    return (uint8_t)event < PHASE_EVENT_COUNT ? phaseEventNames[(uint8_t)event] : "UNKNOWN";
+}
+
+GamePhase parseGamePhase(const char* name) {
+    if (name == nullptr) return GamePhase::INVALID;
+    for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+        if (strcasecmp(name, gamePhaseNames[p]) == 0) return (GamePhase)p;
+    }
+    return GamePhase::INVALID;
+}
+
+//#### HOOKS ###
+// Appelés après une transition validée, dans la tâche qui a émis la commande
+typedef void (*PhaseHook)(GamePhase from, GamePhase to, PhaseEvent event);
+
+PhaseHook phaseExitHooks[PHASE_COUNT] = {};
+PhaseHook phaseEntryHooks[PHASE_COUNT] = {};
+
+void onPhaseExit(GamePhase phase, PhaseHook hook) {
+    phaseExitHooks[(uint8_t)phase] = hook;
+}
+
+void onPhaseEntry(GamePhase phase, PhaseHook hook) {
+    phaseEntryHooks[(uint8_t)phase] = hook;
+}
+
+bool canFirePhase(PhaseEvent event) {
+    return nextGamePhase(getPhase(), event) != GamePhase::INVALID;
+}
+
+// Applique la commande si la table l'autorise (CAS: deux commandes concurrentes ne
+// peuvent pas partir de la même phase). Les hooks sont lancés ensuite par runPhaseHooks.
+bool tryPhaseEvent(PhaseEvent event, GamePhase& from, GamePhase& to) {
+    from = getPhase();
+    do {
+        to = nextGamePhase(from, event);
+        if (to == GamePhase::INVALID) {
+            ESP_LOGW(PHASE_TAG, "Transition refused: %s in phase %s", phaseEventName(event), gamePhaseName(from));
+            return false;
+        }
+    } while (!currentGamePhase().compare_exchange_weak(from, to, std::memory_order_acq_rel, std::memory_order_acquire));
+
+    ESP_LOGI(PHASE_TAG, "[%u] %s: %s -> %s", currentSession(), phaseEventName(event), gamePhaseName(from), gamePhaseName(to));
+    return true;
+}
+
+void runPhaseHooks(GamePhase from, GamePhase to, PhaseEvent event) {
+    if (phaseExitHooks[(uint8_t)from]) phaseExitHooks[(uint8_t)from](from, to, event);
+    if (phaseEntryHooks[(uint8_t)to]) phaseEntryHooks[(uint8_t)to](from, to, event);
+}
+
+// Restauration sans hooks (chargement de la sauvegarde)
+void restoreGamePhase(GamePhase phase) {
+    if (phase != GamePhase::INVALID) {
+        currentGamePhase().store(phase, std::memory_order_release);
+    }
+}
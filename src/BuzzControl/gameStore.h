@@ -0,0 +1,1107 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "Common/jsonArena.h"
+#include "gamePhase.h"
+
+#include <ArduinoJson.h>
+#include <atomic>
+#include <memory>
+
+class AsyncClient;
+
+static const char* STORE_TAG = "GAME_STORE";
+
+// Capacités fixes des tables de jeu (aucune allocation pendant la partie)
+#define MAX_BUMPERS 32
+#define MAX_TEAMS   16
+#define NO_SLOT     0xFF
+
+typedef uint8_t slot_t;
+
+enum class EntityStatus : uint8_t { NONE = 0, READY, PAUSE };
+enum class ReadyState : uint8_t { UNSET = 0, READY, NOT_READY };
+
+// Champs "chauds": lus/écrits à chaque buzz, compacts et contigus en mémoire
+// Les champs de manche (TIMESTAMP, BUTTON, STATUS, BUMPER) ne valent que si "epoch" est
+// la manche courante: une nouvelle manche se résume à incrémenter roundEpoch.
+struct BumperHot {
+    int64_t timestamp;      // TIMESTAMP du buzz de la manche, 0 = pas de buzz
+    int32_t score;
+    uint32_t epoch;         // manche des champs TIMESTAMP/BUTTON/STATUS
+    slot_t team;            // NO_SLOT = pas d'équipe
+    EntityStatus status;
+    ReadyState ready;
+    char button[8];
+};
+
+struct TeamHot {
+    int64_t timestamp;
+    int32_t score;
+    uint32_t epoch;         // manche des champs TIMESTAMP/BUMPER/STATUS
+    slot_t bumper;          // premier bumper ayant buzzé
+    EntityStatus status;
+    ReadyState ready;
+};
+
+// Champs "froids": identifiants; le reste (NAME, COLOR, VERSION...) vit dans coldFields
+struct BumperCold {
+    char id[18];            // MAC "AA:BB:CC:DD:EE:FF"
+    char ip[16];
+};
+
+struct TeamCold {
+    char id[32];
+};
+
+// La phase n'est pas stockée ici: elle est portée par sessionPhases (gamePhase.h)
+struct GameRecord {
+    int64_t time;
+    int32_t currentTime;
+    int32_t delay;
+};
+
+// Champs suivis individuellement pour les mises à jour différentielles
+enum BumperField : uint8_t { BF_SCORE, BF_TEAM, BF_TIMESTAMP, BF_BUTTON, BF_STATUS, BF_READY, BF_IP, BF_COLD, BF_COUNT };
+enum TeamField : uint8_t { TF_SCORE, TF_TIMESTAMP, TF_BUMPER, TF_STATUS, TF_READY, TF_COLD, TF_COUNT };
+enum GameField : uint8_t { GF_PHASE, GF_TIME, GF_CURRENT_TIME, GF_DELAY, GF_COLD, GF_COUNT };
+
+// Version de chaque champ: un delta "depuis V" contient les champs dont la version est > V
+struct StateVersions {
+    uint32_t current;       // version monotone de l'état, incrémentée à chaque modification
+    uint32_t structure;     // dernière suppression/remplacement d'entités: impose un snapshot complet
+    uint32_t round;         // dernière nouvelle manche: les champs de manche de toutes les entités ont changé
+    uint32_t bumper[MAX_BUMPERS][BF_COUNT];
+    uint32_t team[MAX_TEAMS][TF_COUNT];
+    uint32_t game[GF_COUNT];
+};
+
+// Partie copiable de l'état: c'est elle qui est figée dans les snapshots
+struct StoreTables {
+    BumperHot  bumperHot[MAX_BUMPERS];
+    TeamHot    teamHot[MAX_TEAMS];
+    BumperCold bumperCold[MAX_BUMPERS];
+    TeamCold   teamCold[MAX_TEAMS];
+    bool       bumperUsed[MAX_BUMPERS];
+    bool       teamUsed[MAX_TEAMS];
+    GameRecord game;
+    uint32_t   roundEpoch;  // manche courante
+    StateVersions versions;
+};
+
+// Compteurs de disponibilité de la phase PREPARE, tenus à jour à chaque PONG.
+// Recalculés en entier seulement après un changement d'équipes ou de bumpers (stale).
+struct ReadinessCounters {
+    uint8_t expected[MAX_TEAMS];   // bumpers de l'équipe attendus (READY ou NOT_READY)
+    uint8_t pending[MAX_TEAMS];    // bumpers de l'équipe n'ayant pas encore répondu
+    uint8_t teamsNotReady;         // équipes avec au moins un bumper en attente
+    bool stale;
+};
+
+// Table à adressage ouvert clé 64 bits -> slot (O(1)), dimensionnée au double de la capacité.
+// Les slots sont stockés +1: une table à zéro est vide sans initialisation.
+#define INDEX_SIZE      64
+#define INDEX_EMPTY     0x00
+#define INDEX_TOMBSTONE 0xFF
+
+struct SlotIndex {
+    uint64_t keys[INDEX_SIZE];
+    uint8_t  entries[INDEX_SIZE];
+};
+
+struct GameStore : StoreTables {
+    AsyncClient* bumperClient[MAX_BUMPERS];  // connexion TCP du buzzer, clé d'index uniquement
+    uint32_t   bumperConnTag[MAX_BUMPERS];   // indice et génération de cette connexion, 0 = aucune
+    uint32_t   coldRevision;                 // incrémenté à chaque modification de coldFields
+    ReadinessCounters readiness;
+    SlotIndex  bumperIdIndex;
+    SlotIndex  bumperIpIndex;
+    SlotIndex  bumperClientIndex;
+    SlotIndex  teamIdIndex;
+    // Pool des champs froids: compté pour mesurer le gaspillage (clés supprimées ou remplacées)
+    CountingJsonAllocator coldAllocator;
+    // Champs rarement modifiés, conservés tels quels pour le fil et la sauvegarde:
+    // {"bumpers": {id: {...}}, "teams": {id: {...}}, "GAME": {...}}
+    JsonDocument coldFields{&coldAllocator};
+};
+
+// État figé publié par les écrivains; les lecteurs (envoi, HTTP) le sérialisent sans verrou.
+// Les champs froids ne sont recopiés que s'ils ont changé depuis le snapshot précédent.
+struct StateSnapshot {
+    StoreTables tables;
+    GamePhase phase;
+    uint32_t coldRevision;
+    std::shared_ptr<const JsonDocument> cold;
+};
+
+// Emplacement de l'anneau des snapshots publiés (voir SNAPSHOTS)
+struct SnapshotSlot {
+    StateSnapshot state;
+    std::atomic<uint16_t> pins;     // lecteurs qui le tiennent
+};
+
+// Snapshot épinglé: l'emplacement n'est pas réécrit tant qu'un pointeur le désigne
+class SnapshotPtr {
+public:
+    SnapshotPtr() = default;
+    SnapshotPtr(const StateSnapshot* state, SnapshotSlot* slot) : state_(state), slot_(slot) {}
+    SnapshotPtr(const SnapshotPtr& other) : state_(other.state_), slot_(other.slot_) {
+        if (slot_ != nullptr) slot_->pins++;
+    }
+    SnapshotPtr& operator=(SnapshotPtr other) {
+        swap(other);
+        return *this;
+    }
+    ~SnapshotPtr() {
+        if (slot_ != nullptr) slot_->pins--;
+    }
+    void swap(SnapshotPtr& other) {
+        std::swap(state_, other.state_);
+        std::swap(slot_, other.slot_);
+    }
+    const StateSnapshot* operator->() const { return state_; }
+    const StateSnapshot& operator*() const { return *state_; }
+    explicit operator bool() const { return state_ != nullptr; }
+private:
+    const StateSnapshot* state_ = nullptr;
+    SnapshotSlot* slot_ = nullptr;     // nullptr: snapshot vide statique, jamais réécrit
+};
+
+// Un store par session (session.h)
+GameStore gameStores[MAX_SESSIONS];
+
+inline GameStore& gameStore() {
+    return gameStores[currentSession()];
+}
+
+/* **** CONVERSIONS *** */
+
+const char* entityStatusName(EntityStatus status) {
+    switch (status) {
+        case EntityStatus::READY: return "READY";
+        case EntityStatus::PAUSE: return "PAUSE";
+        default:                  return "";
+    }
+}
+
+EntityStatus parseEntityStatus(const char* status) {
+    if (status == nullptr) return EntityStatus::NONE;
+    if (strcmp(status, "PAUSE") == 0) return EntityStatus::PAUSE;
+    if (strcmp(status, "READY") == 0) return EntityStatus::READY;
+    return EntityStatus::NONE;
+}
+
+ReadyState parseReadyState(JsonVariantConst ready) {
+    if (ready.isNull()) return ReadyState::UNSET;
+    if (ready.is<bool>()) return ready.as<bool>() ? ReadyState::READY : ReadyState::NOT_READY;
+    const char* value = ready.as<const char*>();
+    if (value == nullptr) return ReadyState::UNSET;
+    return strcasecmp(value, "TRUE") == 0 ? ReadyState::READY : ReadyState::NOT_READY;
+}
+
+void copyFixed(char* dest, size_t size, const char* src) {
+    if (src == nullptr) src = "";
+    strncpy(dest, src, size - 1);
+    dest[size - 1] = '\0';
+}
+
+// Identifiant JSON en chaîne ou en nombre ("3" ou 3), sans String intermédiaire
+const char* idArg(JsonVariantConst value, char* buffer, size_t size) {
+    if (value.is<const char*>()) return value.as<const char*>();
+    if (value.is<long>()) {
+        snprintf(buffer, size, "%ld", value.as<long>());
+        return buffer;
+    }
+    return "";
+}
+
+/* **** VERSIONS *** */
+
+uint32_t getStateVersion() {
+    return gameStore().versions.current;
+}
+
+// Classement (ranking.h): repositionne l'entité dont le score vient de changer
+void rankBumper(slot_t slot);
+void rankTeam(slot_t slot);
+void invalidateRanking();
+
+void markBumper(slot_t slot, BumperField field) {
+    gameStore().versions.bumper[slot][field] = ++gameStore().versions.current;
+    if (field == BF_COLD) gameStore().coldRevision++;
+    if (field == BF_SCORE) rankBumper(slot);
+}
+
+void markTeam(slot_t slot, TeamField field) {
+    gameStore().versions.team[slot][field] = ++gameStore().versions.current;
+    if (field == TF_COLD) gameStore().coldRevision++;
+    if (field == TF_SCORE) rankTeam(slot);
+}
+
+void markGame(GameField field) {
+    gameStore().versions.game[field] = ++gameStore().versions.current;
+    if (field == GF_COLD) gameStore().coldRevision++;
+}
+
+// Entités supprimées ou remplacées: les clients doivent repartir d'un snapshot complet
+void markStructure() {
+    gameStore().versions.structure = ++gameStore().versions.current;
+    gameStore().coldRevision++;
+    gameStore().readiness.stale = true;
+    invalidateRanking();
+}
+
+void markBumperCreated(slot_t slot) {
+    gameStore().coldRevision++;
+    gameStore().readiness.stale = true;
+    invalidateRanking();
+    uint32_t version = ++gameStore().versions.current;
+    for (uint8_t field = 0; field < BF_COUNT; field++) {
+        gameStore().versions.bumper[slot][field] = version;
+    }
+}
+
+void markTeamCreated(slot_t slot) {
+    gameStore().coldRevision++;
+    gameStore().readiness.stale = true;
+    invalidateRanking();
+    uint32_t version = ++gameStore().versions.current;
+    for (uint8_t field = 0; field < TF_COUNT; field++) {
+        gameStore().versions.team[slot][field] = version;
+    }
+}
+
+/* **** MANCHES *** */
+
+bool isBumperRoundField(uint8_t field) {
+    return field == BF_TIMESTAMP || field == BF_BUTTON || field == BF_STATUS;
+}
+
+bool isTeamRoundField(uint8_t field) {
+    return field == TF_TIMESTAMP || field == TF_BUMPER || field == TF_STATUS;
+}
+
+// Nouvelle manche en O(1): les champs des manches précédentes se lisent vides
+void startNewRound() {
+    gameStore().roundEpoch++;
+    gameStore().versions.round = ++gameStore().versions.current;
+}
+
+// Écrivain: rattache les champs de manche à la manche courante avant de les modifier
+BumperHot& bumperRound(slot_t slot) {
+    BumperHot& hot = gameStore().bumperHot[slot];
+    if (hot.epoch != gameStore().roundEpoch) {
+        hot.timestamp = 0;
+        hot.button[0] = '\0';
+        hot.status = EntityStatus::NONE;
+        hot.epoch = gameStore().roundEpoch;
+    }
+    return hot;
+}
+
+TeamHot& teamRound(slot_t slot) {
+    TeamHot& hot = gameStore().teamHot[slot];
+    if (hot.epoch != gameStore().roundEpoch) {
+        hot.timestamp = 0;
+        hot.bumper = NO_SLOT;
+        hot.status = EntityStatus::NONE;
+        hot.epoch = gameStore().roundEpoch;
+    }
+    return hot;
+}
+
+/* **** SLOTS *** */
+
+const char* bumperIdOf(slot_t slot) {
+    return gameStore().bumperCold[slot].id;
+}
+
+const char* teamIdOf(slot_t slot) {
+    return gameStore().teamCold[slot].id;
+}
+
+/* **** INDEX *** */
+
+inline uint8_t indexBucket(uint64_t key) {
+    return (uint8_t)((key * 0x9E3779B97F4A7C15ULL) >> 58);  // 6 bits de poids fort = INDEX_SIZE
+}
+
+slot_t indexFind(const SlotIndex& index, uint64_t key) {
+    uint8_t bucket = indexBucket(key);
+    for (uint8_t probe = 0; probe < INDEX_SIZE; probe++) {
+        uint8_t entry = index.entries[bucket];
+        if (entry == INDEX_EMPTY) return NO_SLOT;
+        if (entry != INDEX_TOMBSTONE && index.keys[bucket] == key) return entry - 1;
+        bucket = (bucket + 1) & (INDEX_SIZE - 1);
+    }
+    return NO_SLOT;
+}
+
+void indexRemove(SlotIndex& index, uint64_t key) {
+    uint8_t bucket = indexBucket(key);
+    for (uint8_t probe = 0; probe < INDEX_SIZE; probe++) {
+        uint8_t entry = index.entries[bucket];
+        if (entry == INDEX_EMPTY) return;
+        if (entry != INDEX_TOMBSTONE && index.keys[bucket] == key) {
+            index.entries[bucket] = INDEX_TOMBSTONE;
+            return;
+        }
+        bucket = (bucket + 1) & (INDEX_SIZE - 1);
+    }
+}
+
+void indexPut(SlotIndex& index, uint64_t key, slot_t slot) {
+    indexRemove(index, key);
+    uint8_t bucket = indexBucket(key);
+    for (uint8_t probe = 0; probe < INDEX_SIZE; probe++) {
+        uint8_t entry = index.entries[bucket];
+        if (entry == INDEX_EMPTY || entry == INDEX_TOMBSTONE) {
+            index.keys[bucket] = key;
+            index.entries[bucket] = slot + 1;
+            return;
+        }
+        bucket = (bucket + 1) & (INDEX_SIZE - 1);
+    }
+    ESP_LOGE(STORE_TAG, "Slot index full");
+}
+
+void indexClear(SlotIndex& index) {
+    memset(index.entries, INDEX_EMPTY, sizeof(index.entries));
+}
+
+// FNV-1a, bit de poids fort forcé pour ne pas recouvrir l'espace des MAC (48 bits)
+uint64_t stringKey(const char* str) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (; *str; str++) {
+        hash = (hash ^ (uint8_t)*str) * 0x100000001b3ULL;
+    }
+    return hash | (1ULL << 63);
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "AA:BB:CC:DD:EE:FF" -> 48 bits; les autres identifiants sont hachés
+uint64_t bumperKey(const char* bumperID) {
+    uint64_t mac = 0;
+    for (int i = 0; i < 17; i++) {
+        char c = bumperID[i];
+        if (i % 3 == 2) {
+            if (c != ':' && c != '-') return stringKey(bumperID);
+            continue;
+        }
+        int v = hexValue(c);
+        if (v < 0) return stringKey(bumperID);
+        mac = (mac << 4) | v;
+    }
+    return bumperID[17] == '\0' ? mac : stringKey(bumperID);
+}
+
+// "a.b.c.d" -> 32 bits, 0 si invalide
+uint32_t ipv4Key(const char* ip) {
+    if (ip == nullptr) return 0;
+    uint32_t result = 0;
+    for (int octet = 0; octet < 4; octet++) {
+        if (*ip < '0' || *ip > '9') return 0;
+        uint32_t value = 0;
+        while (*ip >= '0' && *ip <= '9') {
+            value = value * 10 + (*ip++ - '0');
+            if (value > 255) return 0;
+        }
+        result = (result << 8) | value;
+        if (octet < 3 && *ip++ != '.') return 0;
+    }
+    return *ip == '\0' ? result : 0;
+}
+
+slot_t findBumperSlot(const char* bumperID) {
+    if (bumperID == nullptr || bumperID[0] == '\0') return NO_SLOT;
+    slot_t slot = indexFind(gameStore().bumperIdIndex, bumperKey(bumperID));
+    if (slot != NO_SLOT && strcmp(gameStore().bumperCold[slot].id, bumperID) != 0) {
+        ESP_LOGW(STORE_TAG, "Bumper key collision %s / %s", bumperID, gameStore().bumperCold[slot].id);
+        return NO_SLOT;
+    }
+    return slot;
+}
+
+slot_t findTeamSlot(const char* teamID) {
+    if (teamID == nullptr || teamID[0] == '\0') return NO_SLOT;
+    slot_t slot = indexFind(gameStore().teamIdIndex, stringKey(teamID));
+    if (slot != NO_SLOT && strcmp(gameStore().teamCold[slot].id, teamID) != 0) {
+        ESP_LOGW(STORE_TAG, "Team key collision %s / %s", teamID, gameStore().teamCold[slot].id);
+        return NO_SLOT;
+    }
+    return slot;
+}
+
+slot_t findBumperSlotByIP(const char* ip) {
+    uint32_t key = ipv4Key(ip);
+    return key == 0 ? NO_SLOT : indexFind(gameStore().bumperIpIndex, key);
+}
+
+slot_t findBumperSlotByClient(const AsyncClient* client) {
+    return client == nullptr ? NO_SLOT : indexFind(gameStore().bumperClientIndex, (uintptr_t)client);
+}
+
+// Session d'un buzzer: celle qui tient sa connexion, sinon celle qui connaît sa MAC
+session_t findBumperSession(const char* bumperID, const AsyncClient* client) {
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        SessionScope scope(session);
+        if (findBumperSlotByClient(client) != NO_SLOT) return session;
+    }
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        SessionScope scope(session);
+        if (findBumperSlot(bumperID) != NO_SLOT) return session;
+    }
+    return NO_SESSION;
+}
+
+void setBumperIPSlot(slot_t slot, const char* ip) {
+    BumperCold& cold = gameStore().bumperCold[slot];
+    uint32_t oldKey = ipv4Key(cold.ip);
+    if (oldKey != 0 && indexFind(gameStore().bumperIpIndex, oldKey) == slot) indexRemove(gameStore().bumperIpIndex, oldKey);
+    copyFixed(cold.ip, sizeof(cold.ip), ip);
+    uint32_t key = ipv4Key(cold.ip);
+    if (key != 0) indexPut(gameStore().bumperIpIndex, key, slot);
+    markBumper(slot, BF_IP);
+}
+
+// Associe la connexion TCP courante au buzzer (HELLO, puis tout message identifié).
+// tag: indice et génération de la connexion; une nouvelle connexion à la même adresse
+// remplace le tag de l'ancienne.
+void bindBumperClient(slot_t slot, AsyncClient* client, uint32_t tag) {
+    if (client == nullptr) return;
+    if (gameStore().bumperClient[slot] == client) {
+        gameStore().bumperConnTag[slot] = tag;
+        return;
+    }
+    slot_t previous = findBumperSlotByClient(client);
+    if (previous != NO_SLOT) {
+        gameStore().bumperClient[previous] = nullptr;
+        gameStore().bumperConnTag[previous] = 0;
+    }
+    if (gameStore().bumperClient[slot] != nullptr) indexRemove(gameStore().bumperClientIndex, (uintptr_t)gameStore().bumperClient[slot]);
+    gameStore().bumperClient[slot] = client;
+    gameStore().bumperConnTag[slot] = tag;
+    indexPut(gameStore().bumperClientIndex, (uintptr_t)client, slot);
+}
+
+// Connexion fermée: le pointeur n'est utilisé que comme clé, jamais déréférencé. Le tag
+// doit aussi correspondre: sinon l'adresse a été reprise par une connexion plus récente.
+void unbindBumperClient(const AsyncClient* client, uint32_t tag) {
+    slot_t slot = findBumperSlotByClient(client);
+    if (slot == NO_SLOT || gameStore().bumperConnTag[slot] != tag) return;
+    indexRemove(gameStore().bumperClientIndex, (uintptr_t)client);
+    gameStore().bumperClient[slot] = nullptr;
+    gameStore().bumperConnTag[slot] = 0;
+}
+
+JsonObject bumperColdObj(slot_t slot) {
+    return gameStore().coldFields["bumpers"][bumperIdOf(slot)].as<JsonObject>();
+}
+
+JsonObject teamColdObj(slot_t slot) {
+    return gameStore().coldFields["teams"][teamIdOf(slot)].as<JsonObject>();
+}
+
+JsonObject gameColdObj() {
+    JsonVariant game = gameStore().coldFields["GAME"];
+    if (game.isNull()) {
+        return game.to<JsonObject>();
+    }
+    return game.as<JsonObject>();
+}
+
+slot_t allocBumperSlot(const char* bumperID) {
+    slot_t slot = findBumperSlot(bumperID);
+    if (slot != NO_SLOT) return slot;
+    if (bumperID == nullptr || bumperID[0] == '\0') {
+        ESP_LOGE(STORE_TAG, "Invalid bumperID provided");
+        return NO_SLOT;
+    }
+    for (slot = 0; slot < MAX_BUMPERS; slot++) {
+        if (!gameStore().bumperUsed[slot]) {
+            gameStore().bumperUsed[slot] = true;
+            gameStore().bumperHot[slot] = BumperHot{};
+            gameStore().bumperHot[slot].team = NO_SLOT;
+            gameStore().bumperCold[slot] = BumperCold{};
+            copyFixed(gameStore().bumperCold[slot].id, sizeof(gameStore().bumperCold[slot].id), bumperID);
+            gameStore().bumperClient[slot] = nullptr;
+            gameStore().bumperConnTag[slot] = 0;
+            indexPut(gameStore().bumperIdIndex, bumperKey(bumperIdOf(slot)), slot);
+            gameStore().coldFields["bumpers"][bumperIdOf(slot)].to<JsonObject>();
+            markBumperCreated(slot);
+            ESP_LOGD(STORE_TAG, "Bumper %s => slot %u", bumperID, slot);
+            return slot;
+        }
+    }
+    ESP_LOGE(STORE_TAG, "Bumper table full (%d), %s ignored", MAX_BUMPERS, bumperID);
+    return NO_SLOT;
+}
+
+slot_t allocTeamSlot(const char* teamID) {
+    slot_t slot = findTeamSlot(teamID);
+    if (slot != NO_SLOT) return slot;
+    if (teamID == nullptr || teamID[0] == '\0') {
+        ESP_LOGE(STORE_TAG, "Invalid teamID provided");
+        return NO_SLOT;
+    }
+    for (slot = 0; slot < MAX_TEAMS; slot++) {
+        if (!gameStore().teamUsed[slot]) {
+            gameStore().teamUsed[slot] = true;
+            gameStore().teamHot[slot] = TeamHot{};
+            gameStore().teamHot[slot].bumper = NO_SLOT;
+            gameStore().teamCold[slot] = TeamCold{};
+            copyFixed(gameStore().teamCold[slot].id, sizeof(gameStore().teamCold[slot].id), teamID);
+            indexPut(gameStore().teamIdIndex, stringKey(teamIdOf(slot)), slot);
+            gameStore().coldFields["teams"][teamIdOf(slot)].to<JsonObject>();
+            markTeamCreated(slot);
+            ESP_LOGD(STORE_TAG, "Team %s => slot %u", teamID, slot);
+            return slot;
+        }
+    }
+    ESP_LOGE(STORE_TAG, "Team table full (%d), %s ignored", MAX_TEAMS, teamID);
+    return NO_SLOT;
+}
+
+void freeBumperSlot(slot_t slot) {
+    if (slot >= MAX_BUMPERS || !gameStore().bumperUsed[slot]) return;
+    gameStore().coldFields["bumpers"].remove(bumperIdOf(slot));
+    indexRemove(gameStore().bumperIdIndex, bumperKey(bumperIdOf(slot)));
+    uint32_t ipKey = ipv4Key(gameStore().bumperCold[slot].ip);
+    if (ipKey != 0 && indexFind(gameStore().bumperIpIndex, ipKey) == slot) indexRemove(gameStore().bumperIpIndex, ipKey);
+    if (gameStore().bumperClient[slot] != nullptr) indexRemove(gameStore().bumperClientIndex, (uintptr_t)gameStore().bumperClient[slot]);
+    gameStore().bumperClient[slot] = nullptr;
+    gameStore().bumperConnTag[slot] = 0;
+    for (slot_t t = 0; t < MAX_TEAMS; t++) {
+        if (gameStore().teamUsed[t] && gameStore().teamHot[t].bumper == slot) {
+            gameStore().teamHot[t].bumper = NO_SLOT;
+        }
+    }
+    gameStore().bumperUsed[slot] = false;
+    markStructure();
+}
+
+void freeTeamSlot(slot_t slot) {
+    if (slot >= MAX_TEAMS || !gameStore().teamUsed[slot]) return;
+    gameStore().coldFields["teams"].remove(teamIdOf(slot));
+    indexRemove(gameStore().teamIdIndex, stringKey(teamIdOf(slot)));
+    for (slot_t b = 0; b < MAX_BUMPERS; b++) {
+        if (gameStore().bumperUsed[b] && gameStore().bumperHot[b].team == slot) {
+            gameStore().bumperHot[b].team = NO_SLOT;
+        }
+    }
+    gameStore().teamUsed[slot] = false;
+    markStructure();
+}
+
+void clearBumperSlots() {
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+        freeBumperSlot(slot);
+    }
+    // Repart d'index sans tombstones
+    indexClear(gameStore().bumperIdIndex);
+    indexClear(gameStore().bumperIpIndex);
+    indexClear(gameStore().bumperClientIndex);
+    gameStore().coldFields["bumpers"].to<JsonObject>();
+}
+
+void clearTeamSlots() {
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+        freeTeamSlot(slot);
+    }
+    indexClear(gameStore().teamIdIndex);
+    gameStore().coldFields["teams"].to<JsonObject>();
+}
+
+/* **** JSON <-> STORE *** */
+
+// Clés remises à zéro à chaque manche: jamais conservées dans les champs froids
+bool isRoundKey(const char* key) {
+    return strcmp(key, "TIME") == 0 || strcmp(key, "TIMESTAMP") == 0 || strcmp(key, "BUTTON") == 0
+        || strcmp(key, "STATUS") == 0 || strcmp(key, "BUMPER") == 0;
+}
+
+void loadBumperFields(slot_t slot, JsonObjectConst src) {
+    BumperHot& hot = gameStore().bumperHot[slot];
+    JsonObject cold = bumperColdObj(slot);
+    for (JsonPairConst kv : src) {
+        const char* key = kv.key().c_str();
+        if (strcmp(key, "SCORE") == 0) {
+            hot.score = kv.value().as<int32_t>();
+            markBumper(slot, BF_SCORE);
+        } else if (strcmp(key, "TEAM") == 0) {
+            const char* team = kv.value().as<const char*>();
+            hot.team = (team != nullptr && team[0] != '\0') ? allocTeamSlot(team) : NO_SLOT;
+            markBumper(slot, BF_TEAM);
+            gameStore().readiness.stale = true;
+        } else if (strcmp(key, "TIMESTAMP") == 0) {
+            bumperRound(slot).timestamp = kv.value().as<int64_t>();
+            markBumper(slot, BF_TIMESTAMP);
+        } else if (strcmp(key, "BUTTON") == 0) {
+            copyFixed(bumperRound(slot).button, sizeof(hot.button), kv.value().as<const char*>());
+            markBumper(slot, BF_BUTTON);
+        } else if (strcmp(key, "STATUS") == 0) {
+            bumperRound(slot).status = parseEntityStatus(kv.value().as<const char*>());
+            markBumper(slot, BF_STATUS);
+        } else if (strcmp(key, "READY") == 0) {
+            hot.ready = parseReadyState(kv.value());
+            markBumper(slot, BF_READY);
+            gameStore().readiness.stale = true;
+        } else if (strcmp(key, "IP") == 0) {
+            setBumperIPSlot(slot, kv.value().as<const char*>());
+        } else if (!isRoundKey(key)) {
+            cold[key] = kv.value();
+            markBumper(slot, BF_COLD);
+        }
+    }
+}
+
+void loadTeamFields(slot_t slot, JsonObjectConst src) {
+    TeamHot& hot = gameStore().teamHot[slot];
+    JsonObject cold = teamColdObj(slot);
+    for (JsonPairConst kv : src) {
+        const char* key = kv.key().c_str();
+        if (strcmp(key, "SCORE") == 0) {
+            hot.score = kv.value().as<int32_t>();
+            markTeam(slot, TF_SCORE);
+        } else if (strcmp(key, "TIMESTAMP") == 0) {
+            teamRound(slot).timestamp = kv.value().as<int64_t>();
+            markTeam(slot, TF_TIMESTAMP);
+        } else if (strcmp(key, "BUMPER") == 0) {
+            teamRound(slot).bumper = findBumperSlot(kv.value().as<const char*>());
+            markTeam(slot, TF_BUMPER);
+        } else if (strcmp(key, "STATUS") == 0) {
+            teamRound(slot).status = parseEntityStatus(kv.value().as<const char*>());
+            markTeam(slot, TF_STATUS);
+        } else if (strcmp(key, "READY") == 0) {
+            hot.ready = parseReadyState(kv.value());
+            markTeam(slot, TF_READY);
+            gameStore().readiness.stale = true;
+        } else if (!isRoundKey(key)) {
+            cold[key] = kv.value();
+            markTeam(slot, TF_COLD);
+        }
+    }
+}
+
+void loadGameFields(JsonObjectConst src) {
+    GameRecord& game = gameStore().game;
+    JsonObject cold = gameColdObj();
+    for (JsonPairConst kv : src) {
+        const char* key = kv.key().c_str();
+        if (strcmp(key, "PHASE") == 0) {
+            restoreGamePhase(parseGamePhase(kv.value().as<const char*>()));
+            markGame(GF_PHASE);
+        } else if (strcmp(key, "TIME") == 0) {
+            game.time = kv.value().as<int64_t>();
+            markGame(GF_TIME);
+        } else if (strcmp(key, "CURRENT_TIME") == 0) {
+            game.currentTime = kv.value().as<int32_t>();
+            markGame(GF_CURRENT_TIME);
+        } else if (strcmp(key, "DELAY") == 0) {
+            game.delay = kv.value().as<int32_t>();
+            markGame(GF_DELAY);
+        } else {
+            cold[key] = kv.value();
+            markGame(GF_COLD);
+        }
+    }
+}
+
+// Écrit un champ; en mode delta un champ vidé est publié à null pour que le client l'efface
+void writeBumperField(const StateSnapshot& s, slot_t slot, BumperField field, JsonObject dst, bool delta) {
+    const BumperHot& hot = s.tables.bumperHot[slot];
+    bool round = hot.epoch == s.tables.roundEpoch;
+    switch (field) {
+        case BF_SCORE:
+            dst["SCORE"] = hot.score;
+            break;
+        case BF_TEAM:
+            if (hot.team != NO_SLOT) dst["TEAM"] = (const char*)s.tables.teamCold[hot.team].id;
+            else if (delta) dst["TEAM"] = nullptr;
+            break;
+        case BF_TIMESTAMP:
+            if (round && hot.timestamp != 0) dst["TIMESTAMP"] = hot.timestamp;
+            else if (delta) dst["TIMESTAMP"] = nullptr;
+            break;
+        case BF_BUTTON:
+            if (round && hot.button[0] != '\0') dst["BUTTON"] = (const char*)hot.button;
+            else if (delta) dst["BUTTON"] = nullptr;
+            break;
+        case BF_STATUS:
+            if (round && hot.status != EntityStatus::NONE) dst["STATUS"] = entityStatusName(hot.status);
+            else if (delta) dst["STATUS"] = nullptr;
+            break;
+        case BF_READY:
+            if (hot.ready != ReadyState::UNSET) dst["READY"] = hot.ready == ReadyState::READY ? "TRUE" : "FALSE";
+            else if (delta) dst["READY"] = nullptr;
+            break;
+        case BF_IP:
+            if (s.tables.bumperCold[slot].ip[0] != '\0') dst["IP"] = (const char*)s.tables.bumperCold[slot].ip;
+            break;
+        case BF_COLD:
+            for (JsonPairConst kv : (*s.cold)["bumpers"][(const char*)s.tables.bumperCold[slot].id].as<JsonObjectConst>()) {
+                dst[kv.key()] = kv.value();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void writeTeamField(const StateSnapshot& s, slot_t slot, TeamField field, JsonObject dst, bool delta) {
+    const TeamHot& hot = s.tables.teamHot[slot];
+    bool round = hot.epoch == s.tables.roundEpoch;
+    switch (field) {
+        case TF_SCORE:
+            dst["SCORE"] = hot.score;
+            break;
+        case TF_TIMESTAMP:
+            if (round && hot.timestamp != 0) dst["TIMESTAMP"] = hot.timestamp;
+            else if (delta) dst["TIMESTAMP"] = nullptr;
+            break;
+        case TF_BUMPER:
+            if (round && hot.bumper != NO_SLOT) dst["BUMPER"] = (const char*)s.tables.bumperCold[hot.bumper].id;
+            else if (delta) dst["BUMPER"] = nullptr;
+            break;
+        case TF_STATUS:
+            if (round && hot.status != EntityStatus::NONE) dst["STATUS"] = entityStatusName(hot.status);
+            else if (delta) dst["STATUS"] = nullptr;
+            break;
+        case TF_READY:
+            if (hot.ready != ReadyState::UNSET) dst["READY"] = hot.ready == ReadyState::READY ? "TRUE" : "FALSE";
+            else if (delta) dst["READY"] = nullptr;
+            break;
+        case TF_COLD:
+            for (JsonPairConst kv : (*s.cold)["teams"][(const char*)s.tables.teamCold[slot].id].as<JsonObjectConst>()) {
+                dst[kv.key()] = kv.value();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void writeGameField(const StateSnapshot& s, GameField field, JsonObject dst) {
+    const GameRecord& game = s.tables.game;
+    switch (field) {
+        case GF_PHASE:
+            dst["PHASE"] = gamePhaseName(s.phase);
+            break;
+        case GF_TIME:
+            if (game.time != 0) dst["TIME"] = game.time;
+            break;
+        case GF_CURRENT_TIME:
+            dst["CURRENT_TIME"] = game.currentTime;
+            break;
+        case GF_DELAY:
+            dst["DELAY"] = game.delay;
+            break;
+        case GF_COLD:
+            for (JsonPairConst kv : (*s.cold)["GAME"].as<JsonObjectConst>()) {
+                dst[kv.key()] = kv.value();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void writeBumperFields(const StateSnapshot& s, slot_t slot, JsonObject dst) {
+    // Champs froids d'abord: les champs typés font foi en cas de doublon
+    writeBumperField(s, slot, BF_COLD, dst, false);
+    for (uint8_t field = 0; field < BF_COLD; field++) {
+        writeBumperField(s, slot, (BumperField)field, dst, false);
+    }
+}
+
+void writeTeamFields(const StateSnapshot& s, slot_t slot, JsonObject dst) {
+    writeTeamField(s, slot, TF_COLD, dst, false);
+    for (uint8_t field = 0; field < TF_COLD; field++) {
+        writeTeamField(s, slot, (TeamField)field, dst, false);
+    }
+}
+
+void writeGameFields(const StateSnapshot& s, JsonObject dst) {
+    writeGameField(s, GF_COLD, dst);
+    for (uint8_t field = 0; field < GF_COLD; field++) {
+        writeGameField(s, (GameField)field, dst);
+    }
+}
+
+// Remplace toutes les équipes par celles de l'objet JSON (FULL / chargement)
+void loadTeams(JsonObjectConst teams) {
+    clearTeamSlots();
+    for (JsonPairConst kv : teams) {
+        slot_t slot = allocTeamSlot(kv.key().c_str());
+        if (slot != NO_SLOT) {
+            loadTeamFields(slot, kv.value().as<JsonObjectConst>());
+        }
+    }
+}
+
+// Remplace tous les bumpers par ceux de l'objet JSON (FULL / chargement)
+void loadBumpers(JsonObjectConst bumpers) {
+    clearBumperSlots();
+    for (JsonPairConst kv : bumpers) {
+        slot_t slot = allocBumperSlot(kv.key().c_str());
+        if (slot != NO_SLOT) {
+            loadBumperFields(slot, kv.value().as<JsonObjectConst>());
+        }
+    }
+}
+
+// Remplace équipes et bumpers; les BUMPER des équipes sont résolus une fois les bumpers chargés
+void loadTeamsAndBumpers(JsonObjectConst root) {
+    JsonObjectConst teams = root["teams"].as<JsonObjectConst>();
+    loadTeams(teams);
+    loadBumpers(root["bumpers"].as<JsonObjectConst>());
+    for (JsonPairConst kv : teams) {
+        slot_t slot = findTeamSlot(kv.key().c_str());
+        if (slot != NO_SLOT) {
+            teamRound(slot).bumper = findBumperSlot(kv.value()["BUMPER"].as<const char*>());
+            markTeam(slot, TF_BUMPER);
+        }
+    }
+}
+
+void loadStore(JsonObjectConst root) {
+    gameStore().game = GameRecord{};
+    restoreGamePhase(GamePhase::STOP);
+    gameStore().coldFields["GAME"].to<JsonObject>();
+    markStructure();
+    loadTeamsAndBumpers(root);
+    loadGameFields(root["GAME"].as<JsonObjectConst>());
+}
+
+void writeStore(const StateSnapshot& s, JsonDocument& doc) {
+    JsonObject bumpers = doc["bumpers"].to<JsonObject>();
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+        if (s.tables.bumperUsed[slot]) {
+            writeBumperFields(s, slot, bumpers[(const char*)s.tables.bumperCold[slot].id].to<JsonObject>());
+        }
+    }
+    JsonObject teams = doc["teams"].to<JsonObject>();
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+        if (s.tables.teamUsed[slot]) {
+            writeTeamFields(s, slot, teams[(const char*)s.tables.teamCold[slot].id].to<JsonObject>());
+        }
+    }
+    writeGameFields(s, doc["GAME"].to<JsonObject>());
+}
+
+// Delta depuis une version: seules les entités et champs modifiés depuis "since" sont écrits.
+// Retourne false si un snapshot complet est nécessaire (entités supprimées/remplacées depuis).
+bool writeStoreDelta(const StateSnapshot& s, JsonDocument& doc, uint32_t since) {
+    if (s.tables.versions.structure > since) {
+        return false;
+    }
+    // Nouvelle manche depuis "since": les champs de manche de chaque entité sont republiés
+    bool newRound = s.tables.versions.round > since;
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+        if (!s.tables.bumperUsed[slot]) continue;
+        JsonObject bumper;
+        for (uint8_t field = 0; field < BF_COUNT; field++) {
+            if (s.tables.versions.bumper[slot][field] > since || (newRound && isBumperRoundField(field))) {
+                if (bumper.isNull()) bumper = doc["bumpers"][(const char*)s.tables.bumperCold[slot].id].to<JsonObject>();
+                writeBumperField(s, slot, (BumperField)field, bumper, true);
+            }
+        }
+    }
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+        if (!s.tables.teamUsed[slot]) continue;
+        JsonObject team;
+        for (uint8_t field = 0; field < TF_COUNT; field++) {
+            if (s.tables.versions.team[slot][field] > since || (newRound && isTeamRoundField(field))) {
+                if (team.isNull()) team = doc["teams"][(const char*)s.tables.teamCold[slot].id].to<JsonObject>();
+                writeTeamField(s, slot, (TeamField)field, team, true);
+            }
+        }
+    }
+    JsonObject game;
+    for (uint8_t field = 0; field < GF_COUNT; field++) {
+        if (s.tables.versions.game[field] > since) {
+            if (game.isNull()) game = doc["GAME"].to<JsonObject>();
+            writeGameField(s, (GameField)field, game);
+        }
+    }
+    return true;
+}
+
+/* **** SNAPSHOTS *** */
+
+// Anneau fixe par session: l'écrivain fige l'état dans un emplacement ni publié ni épinglé,
+// puis le publie; les lecteurs épinglent le publié le temps de leur lecture. Aucune
+// allocation par publication: seuls les champs froids sont recopiés, et seulement s'ils ont
+// changé. Emplacements: publié, sauvegarde en attente et en cours, envoi, HTTP, écrivain.
+#define SNAPSHOT_SLOTS 6
+
+struct SnapshotRing {
+    SnapshotSlot slots[SNAPSHOT_SLOTS];
+    std::atomic<int8_t> published{-1};
+    uint32_t publishes;
+    uint32_t unchanged;     // rien de neuf depuis la dernière publication
+    uint32_t full;          // tous les emplacements épinglés: publication remise
+};
+
+SnapshotRing snapshotRings[MAX_SESSIONS];
+
+// Côté écrivain: fige l'état courant et le publie, s'il a changé depuis la dernière fois
+void publishSnapshot() {
+    SnapshotRing& ring = snapshotRings[currentSession()];
+    const GameStore& store = gameStore();
+    GamePhase phase = getPhase();
+    int8_t current = ring.published;
+    const StateSnapshot* previous = current >= 0 ? &ring.slots[current].state : nullptr;
+    if (previous != nullptr && previous->tables.versions.current == store.versions.current &&
+        previous->coldRevision == store.coldRevision && previous->phase == phase) {
+        ring.unchanged++;
+        return;
+    }
+
+    int8_t target = -1;
+    for (int8_t i = 0; i < SNAPSHOT_SLOTS && target < 0; i++) {
+        if (i != current && ring.slots[i].pins == 0) target = i;
+    }
+    if (target < 0) {
+        // La prochaine publication reprendra l'état courant
+        ring.full++;
+        ESP_LOGW(STORE_TAG, "All %u snapshot slots pinned, publish deferred", SNAPSHOT_SLOTS);
+        return;
+    }
+
+    StateSnapshot& snapshot = ring.slots[target].state;
+    snapshot.tables = static_cast<const StoreTables&>(store);
+    snapshot.phase = phase;
+    if (previous != nullptr && previous->cold && previous->coldRevision == store.coldRevision) {
+        snapshot.cold = previous->cold;
+    } else {
+        // Copie compacte sur le tas: n'entre pas dans le compte du pool des champs froids
+        std::shared_ptr<JsonDocument> cold = std::make_shared<JsonDocument>(&heapJsonAllocator);
+        cold->set(store.coldFields);
+        snapshot.cold = cold;
+    }
+    snapshot.coldRevision = store.coldRevision;
+    ring.published = target;
+    ring.publishes++;
+}
+
+// Avant la première publication
+const StateSnapshot& emptySnapshot() {
+    static StateSnapshot empty;
+    static bool initialized = [] {
+        empty.cold = std::make_shared<const JsonDocument>();
+        return true;
+    }();
+    (void)initialized;
+    return empty;
+}
+
+// Côté lecteur: épingle le dernier snapshot publié, valable tant que le pointeur est tenu.
+// L'épingle n'est retenue que si l'emplacement est toujours le publié: l'écrivain ne
+// réécrit jamais celui-ci, ni un emplacement épinglé.
+SnapshotPtr pinSnapshot() {
+    SnapshotRing& ring = snapshotRings[currentSession()];
+    while (true) {
+        int8_t index = ring.published;
+        if (index < 0) return SnapshotPtr(&emptySnapshot(), nullptr);
+        SnapshotSlot& slot = ring.slots[index];
+        slot.pins++;
+        if (ring.published == index) return SnapshotPtr(&slot.state, &slot);
+        slot.pins--;
+    }
+}
+
+void writeSnapshotStats(JsonObject dst) {
+    const SnapshotRing& ring = snapshotRings[currentSession()];
+    uint8_t pinned = 0;
+    for (uint8_t i = 0; i < SNAPSHOT_SLOTS; i++) pinned += ring.slots[i].pins > 0;
+    dst["SLOTS"] = SNAPSHOT_SLOTS;
+    dst["PINNED"] = pinned;
+    dst["PUBLISHES"] = ring.publishes;
+    dst["UNCHANGED"] = ring.unchanged;
+    dst["FULL"] = ring.full;
+}
+
+/* **** MÉMOIRE DES CHAMPS FROIDS *** */
+// ArduinoJson ne réutilise pas la place des valeurs supprimées ou remplacées (QUESTION,
+// NAME, COLOR...): entre deux manches, le document est recopié dans un pool neuf si
+// le pool a grossi de plus du seuil depuis la dernière compaction.
+#define COLD_COMPACT_GROWTH 2048   // octets
+#define POOL_HISTORY_SIZE   16
+
+struct PoolSample {
+    uint32_t uptime;        // secondes
+    uint32_t poolBytes;     // après compaction éventuelle
+    uint32_t freeHeap;
+};
+
+struct PoolStats {
+    size_t compactedBytes;  // taille du pool après la dernière compaction
+    uint32_t compactions;
+    size_t reclaimed;       // octets rendus au tas depuis le démarrage
+    PoolSample history[POOL_HISTORY_SIZE];
+    uint8_t historyHead;
+    uint8_t historyCount;
+};
+
+PoolStats sessionPoolStats[MAX_SESSIONS];
+
+void samplePoolUsage() {
+    PoolStats& coldPoolStats = sessionPoolStats[currentSession()];
+    PoolSample& sample = coldPoolStats.history[coldPoolStats.historyHead];
+    sample.uptime = millis() / 1000;
+    sample.poolBytes = gameStore().coldAllocator.used();
+    sample.freeHeap = ESP.getFreeHeap();
+    coldPoolStats.historyHead = (coldPoolStats.historyHead + 1) % POOL_HISTORY_SIZE;
+    if (coldPoolStats.historyCount < POOL_HISTORY_SIZE) coldPoolStats.historyCount++;
+}
+
+// À appeler entre deux manches, depuis la tâche qui modifie l'état
+void compactColdFields() {
+    PoolStats& coldPoolStats = sessionPoolStats[currentSession()];
+    CountingJsonAllocator& coldPoolAllocator = gameStore().coldAllocator;
+    size_t before = coldPoolAllocator.used();
+    if (before >= coldPoolStats.compactedBytes + COLD_COMPACT_GROWTH) {
+        JsonDocument compact(&coldPoolAllocator);
+        compact.set(gameStore().coldFields);
+        compact.shrinkToFit();
+        // L'ancien pool est libéré au plus tard en sortie de portée
+        gameStore().coldFields = std::move(compact);
+    }
+    size_t after = coldPoolAllocator.used();
+    if (after < before) {
+        coldPoolStats.compactions++;
+        coldPoolStats.reclaimed += before - after;
+        coldPoolStats.compactedBytes = after;
+        ESP_LOGI(STORE_TAG, "Cold fields compacted: %u -> %u bytes", (unsigned)before, (unsigned)after);
+    } else if (after > coldPoolStats.compactedBytes + COLD_COMPACT_GROWTH) {
+        // Rien de récupérable: le document a réellement grossi
+        coldPoolStats.compactedBytes = after;
+    }
+    samplePoolUsage();
+    ESP_LOGD(STORE_TAG, "Cold pool %u bytes (peak %u), free heap %u", (unsigned)after, (unsigned)coldPoolAllocator.peak(), (unsigned)ESP.getFreeHeap());
+}
+
+void writePoolStats(JsonObject dst) {
+    const PoolStats& coldPoolStats = sessionPoolStats[currentSession()];
+    const CountingJsonAllocator& coldPoolAllocator = gameStore().coldAllocator;
+    dst["COLD_POOL"] = coldPoolAllocator.used();
+    dst["COLD_POOL_PEAK"] = coldPoolAllocator.peak();
+    dst["COMPACTIONS"] = coldPoolStats.compactions;
+    dst["RECLAIMED"] = coldPoolStats.reclaimed;
+    dst["FREE_HEAP"] = ESP.getFreeHeap();
+    JsonArray history = dst["history"].to<JsonArray>();
+    uint8_t first = (coldPoolStats.historyHead + POOL_HISTORY_SIZE - coldPoolStats.historyCount) % POOL_HISTORY_SIZE;
+    for (uint8_t i = 0; i < coldPoolStats.historyCount; i++) {
+        const PoolSample& sample = coldPoolStats.history[(first + i) % POOL_HISTORY_SIZE];
+        JsonObject entry = history.add<JsonObject>();
+        entry["UPTIME"] = sample.uptime;
+        entry["COLD_POOL"] = sample.poolBytes;
+        entry["FREE_HEAP"] = sample.freeHeap;
+    }
+}
@@ -116,10 +116,8 @@ ButtonInfo buttonsInfo[] = {
 AsyncServer* bumperServer;
 std::vector<AsyncClient*> bumperClients;
 
-volatile bool GameStarted = false;
 int64_t timeRef = 0;
 const int nbTeam = 10;
-std::map<std::string, int64_t> timeRefTeam;
 
 unsigned int localWWWPort = 80;  // Port d'écoute local
 
@@ -132,37 +130,33 @@ static const char* GameFile = "/config/game.json";
 static const char* saveGameFile = "/files/game.json.save";
 static const String questionsPath = "/files/questions";
 
-SemaphoreHandle_t questionMutex = NULL;
-SemaphoreHandle_t buttonMutex = NULL;
-SemaphoreHandle_t updateMutex = NULL;
-
-// Map pour stocker les buffers par client (identifiés par IP)
-std::map<String, String> clientBuffers;
-
 /* **** FUNCTIONS DEFINITIONS *** */
 
-// teamsAndBumpers.h
-//void setGamePhase(String phase);
+// BumperServer.h
+void initGamePhaseHooks();
+struct GameCommand;
+void applyGameCommand(const GameCommand& command);
 
 // messages_to_send.h
 void enqueueOutgoingMessage(const char* action, const char* msg, const char* update, bool notify = false, AsyncClient* client = nullptr);
 void sendMessageToClient(const String& action, const String& msg, const String& update, AsyncClient* client);
 void sendMessageToAllClients(const String& action, const String& msg, const String& update="");
+void enqueueStateUpdate(const char* update = "", bool notify = false);
+void enqueueRanking();
+void enqueueBuzzOrder();
+void nextBuzzTurn();
 void notifyAll();
+void writeMetrics(JsonObject dst);
 
 // messages_received.h
-void enqueueIncomingMessage(const char* source, const char* data, AsyncClient* client);
 //void processDataFromSocket(const char* action, const JsonObject& message);
-void processTCPMessage(const String& data, AsyncClient* client);
-void processWebSocketMessage(const String& data);
 
 // File system management
 String readFile(const String& path, const String& defaultValue = "");
 bool isFileExists(String path);
 bool deleteFile(const char* filePath);
 void loadJson(String path);
-void saveJson();
-void processClientBuffer(const String& clientID, AsyncClient* c);
+void loadAllSessions();
 bool ensureDirectoryExists(const String& path);
 
 // WiFi and server management
@@ -172,7 +166,8 @@ String printLittleFSInfo(bool isShort = false);
 
 // Game management
 void resetBumpersTime();
-void updateScore(const String bumperID, const int points);
+void updateScore(const char* bumperID, const int points);
+void undoScore(const int count);
 void updateTimer(const int Time, const int delta = 0);
 void startGame(const int delay = 33);
 void stopGame();
@@ -180,9 +175,11 @@ void pauseAllGame();
 void pauseGame(AsyncClient* client);
 void continueGame();
 void revealGame();
-void readyGame(const String question = "");
-void deleteQuestion(const String ID);
-void setRemotePage(const String remotePage);
+void readyGame(const char* question = "");
+void deleteQuestion(const char* ID);
+void setRemotePage(const char* remotePage);
+bool moveBumperToSession(const char* bumperID, uint8_t session);
+void sendBumperSession(AsyncClient* client);
 void attachButtons();
 void startBumperServer();
 void checkPingForAllClients();
@@ -2,81 +2,436 @@
 #include "Common/CustomLogger.h"
 #include "Common/led.h"
 #include "messages_to_send.h"
+#include "Common/jsonArena.h"
+#include "allocProbe.h"
+#include "admission.h"
+#include "gameActor.h"
 
 #include <ArduinoJson.h>
+#include <atomic>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 // Configuration
 const char* RECEIVE_TAG = "MSG_RECEIVE";
 
 int receivedMsgId=0;
-// Structure de message pour les messages entrants
+// Arène des documents JSON de la tâche de réception, remise à zéro après chaque message
+JsonArena receiveArena("receive", 16 * 1024);
+
+//#### CONNEXIONS TCP ###
+// Table fixe des connexions buzzer: les messages entrants portent un indice, pas le pointeur.
+// La tâche async_tcp ouvre et ferme les entrées; la tâche de réception résout l'indice et ne
+// libère l'entrée qu'au TCP_CLOSE, donc après tous les messages de la connexion.
+// Chaque ouverture incrémente la génération de l'entrée: indice et génération forment le tag
+// de la connexion, qui la distingue d'une autre servie plus tard par le même AsyncClient*.
+#define MAX_TCP_CONNECTIONS (MAX_BUMPERS + 8)
+#define NO_CONN 0xFF
+
+typedef uint8_t conn_t;
+
+struct TcpConnection {
+    std::atomic<AsyncClient*> client;   // nullptr = entrée libre
+    std::atomic<bool> open;             // false dès la fermeture, avant le TCP_CLOSE
+    uint16_t generation;                // écrite par async_tcp avant open, jamais 0
+    TokenBucket bucket;                 // admission, async_tcp seulement
+};
+
+TcpConnection tcpConnections[MAX_TCP_CONNECTIONS];
+
+// NO_CONN si la table est pleine
+conn_t openConnection(AsyncClient* client) {
+    for (conn_t conn = 0; conn < MAX_TCP_CONNECTIONS; conn++) {
+        AsyncClient* expected = nullptr;
+        if (tcpConnections[conn].client.compare_exchange_strong(expected, client)) {
+            resetBucket(tcpConnections[conn].bucket, ADMIT_TCP_BURST);
+            if (++tcpConnections[conn].generation == 0) tcpConnections[conn].generation = 1;
+            tcpConnections[conn].open = true;
+            return conn;
+        }
+    }
+    return NO_CONN;
+}
+
+// Marque la connexion fermée; l'entrée reste réservée jusqu'au traitement du TCP_CLOSE
+conn_t closeConnection(AsyncClient* client) {
+    for (conn_t conn = 0; conn < MAX_TCP_CONNECTIONS; conn++) {
+        if (tcpConnections[conn].open && tcpConnections[conn].client == client) {
+            tcpConnections[conn].open = false;
+            return conn;
+        }
+    }
+    return NO_CONN;
+}
+
+uint32_t connectionTag(conn_t conn, uint16_t generation) {
+    return ((uint32_t)generation << 8) | conn;
+}
+
+// nullptr si la connexion a été fermée depuis la réception
+AsyncClient* connectionClient(conn_t conn, uint16_t generation) {
+    if (conn >= MAX_TCP_CONNECTIONS || !tcpConnections[conn].open ||
+        tcpConnections[conn].generation != generation) return nullptr;
+    return tcpConnections[conn].client;
+}
+
+// Libère l'entrée et retourne le client qu'elle désignait (clé de délien seulement),
+// nullptr si l'entrée ne porte plus cette génération
+AsyncClient* releaseConnection(conn_t conn, uint16_t generation) {
+    if (conn >= MAX_TCP_CONNECTIONS || tcpConnections[conn].generation != generation) return nullptr;
+    return tcpConnections[conn].client.exchange(nullptr);
+}
+
+bool admitTcpFrame(conn_t conn, bool realtime) {
+    if (conn >= MAX_TCP_CONNECTIONS) return true;
+    TokenBucket& bucket = tcpConnections[conn].bucket;
+    bool admitted = takeToken(bucket, ADMIT_TCP_RATE, ADMIT_TCP_BURST, realtime);
+    logThrottle(bucket, admitted, "TCP connection", conn);
+    return admitted;
+}
+
+//#### ANNEAUX DES MESSAGES ENTRANTS ###
+// Les producteurs (async_tcp, WebSocket) réservent un descripteur et copient la trame une
+// seule fois dans un anneau d'octets fixe: [longueur u16][octets][\0]. La tâche de réception
+// la traite sur place puis la libère, dans l'ordre d'arrivée de sa voie. Aucune allocation à
+// la réception; la capacité se compte en octets.
+// Le producteur ne bloque jamais: réservation sous section critique, copie, puis descripteur
+// marqué prêt. La tâche de réception lit les descripteurs dans l'ordre de réservation et
+// s'arrête au premier qui n'est pas encore prêt. Anneau plein: la trame est écartée.
+//
+// Deux voies, chacune avec son anneau: temps réel (appuis, PONG, commandes de phase), toujours
+// servie en premier, et de fond (HELLO, états complets, fichiers...). Un appui n'attend
+// donc jamais derrière un traitement lourd de l'interface d'administration.
+#ifndef INCOMING_RING_BYTES
+#define INCOMING_RING_BYTES (16 * 1024)
+#endif
+#ifndef INCOMING_REALTIME_BYTES
+#define INCOMING_REALTIME_BYTES (2 * 1024)
+#endif
+#define INCOMING_SLOTS 32
+#define INCOMING_REALTIME_SLOTS 16
+#define INCOMING_HEADER sizeof(uint16_t)
+// Place de fond gardée pour les TCP_CLOSE: une entrée de connexion n'est libérée que par eux
+#define INCOMING_CONTROL_SLOTS 4
+#define INCOMING_CONTROL_BYTES 64
+
+enum class MessageSource : uint8_t { TCP, TCP_CLOSE, WEBSOCKET };
+
+const char* messageSourceName(MessageSource source) {
+    switch (source) {
+        case MessageSource::TCP: return "TCP";
+        case MessageSource::TCP_CLOSE: return "TCP_CLOSE";
+        case MessageSource::WEBSOCKET: return "WebSocket";
+    }
+    return "?";
+}
+
+enum MessageLane : uint8_t { LANE_REALTIME, LANE_BULK, LANE_COUNT };
+
+// Descripteur d'un message entrant
 typedef struct {
-    String source;     // "TCP", "WebSocket", "Button", etc.
-    String* data;      // Contenu du message
-    AsyncClient* client; // Client source (si applicable)
-    int64_t timestamp;  // Horodatage pour le traçage
+    std::atomic<bool> ready;    // copie terminée, lisible par la tâche de réception
+    MessageSource source;
+    conn_t conn;            // Connexion TCP source, NO_CONN sinon
+    uint16_t generation;    // Génération de cette connexion à la réception
+    uint32_t wsClient;      // Client WebSocket source, 0 sinon
+    int64_t timestamp;      // Horodatage pour le traçage
     int msgID;
+    uint32_t offset;        // En-tête de longueur dans l'anneau
+    uint32_t end;           // Première position après la trame
+    uint32_t reserved;      // Octets retenus, fin d'anneau sautée comprise
 } IncomingMessage_t;
 
-// Queue pour les messages entrants
-QueueHandle_t incomingQueue;
+struct IncomingLane {
+    const char* name;
+    uint8_t* bytes;
+    uint32_t capacity;
+    IncomingMessage_t* slots;
+    uint8_t slotCount;
+    uint32_t head;          // Début de la plus ancienne trame non libérée
+    uint32_t tail;          // Prochaine écriture
+    uint32_t used;          // Octets retenus
+    uint8_t nextSlot;
+    uint8_t readSlot;       // Plus ancien descripteur réservé (tâche de réception)
+    uint8_t slotsUsed;      // Profondeur
+    uint8_t depthPeak;
+    uint32_t peak;
+    uint32_t dropped;       // Anneau plein ou trame trop grande
+    uint32_t throttled;     // Refusées par le seau de leur source
+    // Latences (µs): attente en file, puis file + traitement
+    uint32_t processed;
+    uint32_t waitLast;
+    uint32_t waitMax;
+    uint64_t waitTotal;
+    uint32_t totalMax;
+};
 
-// Initialisation de la queue de messages entrants
+uint8_t realtimeBytes[INCOMING_REALTIME_BYTES];
+IncomingMessage_t realtimeSlots[INCOMING_REALTIME_SLOTS];
+uint8_t bulkBytes[INCOMING_RING_BYTES];
+IncomingMessage_t bulkSlots[INCOMING_SLOTS];
+
+IncomingLane incomingLanes[LANE_COUNT] = {
+    {"realtime", realtimeBytes, INCOMING_REALTIME_BYTES, realtimeSlots, INCOMING_REALTIME_SLOTS},
+    {"bulk", bulkBytes, INCOMING_RING_BYTES, bulkSlots, INCOMING_SLOTS},
+};
+portMUX_TYPE incomingRingMux = portMUX_INITIALIZER_UNLOCKED;
+// Réveille la tâche de réception (trames et commandes de jeu); un jeton en trop ne coûte
+// qu'un tour à vide
+SemaphoreHandle_t incomingReady;
+
+// Initialisation des files de messages entrants
 void initIncomingQueue() {
-    incomingQueue = xQueueCreate(30, sizeof(IncomingMessage_t*));
-    if (incomingQueue == NULL) {
+    incomingReady = xSemaphoreCreateCounting(INCOMING_SLOTS + INCOMING_REALTIME_SLOTS + GAME_COMMAND_SLOTS, 0);
+    if (incomingReady == NULL) {
         ESP_LOGE(RECEIVE_TAG, "Failed to create incoming message queue");
     }
 }
 
-void enqueueIncomingMessage(const char* source, const char* data, AsyncClient* client) {
-    IncomingMessage_t* message = new IncomingMessage_t;
-    message->source = source;
-    message->data = new String(data);
-    message->timestamp = micros();
-    message->msgID = receivedMsgId++;
-    message->client = client;
+// Actions servies en priorité: l'appui et ce qui règle la partie en cours. Toutes les
+// commandes de phase sont sur cette voie: d'une même connexion, READY puis START restent
+// dans l'ordre (une voie est FIFO, deux voies ne le sont pas entre elles)
+bool isRealtimeAction(const char* action, size_t length) {
+    static const char* realtime[] = {"BUTTON", "PONG", "READY", "REVEAL", "START", "STOP", "PAUSE", "CONTINUE"};
+    for (const char* name : realtime) {
+        if (strlen(name) == length && memcmp(name, action, length) == 0) return true;
+    }
+    return false;
+}
 
-    if (xQueueSend(incomingQueue, &message, pdMS_TO_TICKS(100)) != pdPASS) {
-        ESP_LOGE(RECEIVE_TAG, "Failed to send message to incoming queue");
-        delete message->data;
-    //    delete message->timestamp;
-        delete message;
-    } else {
-      UBaseType_t messagesWaiting = uxQueueMessagesWaiting(incomingQueue);
+// Valeur de "ACTION" lue sans analyser le JSON; longueur 0 si absente
+size_t findAction(const char* data, size_t length, const char*& action) {
+    static const char key[] = "\"ACTION\"";
+    const char* end = data + length;
+    action = data;
+    for (const char* p = data; p + sizeof(key) - 1 <= end; p++) {
+        if (memcmp(p, key, sizeof(key) - 1) != 0) continue;
+        p += sizeof(key) - 1;
+        while (p < end && (*p == ' ' || *p == ':')) p++;
+        if (p >= end || *p != '"') return 0;
+        action = ++p;
+        while (p < end && *p != '"') p++;
+        return p - action;
+    }
+    return 0;
+}
+
+// Voie d'une trame d'après son "ACTION"
+MessageLane laneOf(MessageSource source, const char* data, size_t length) {
+    // TCP_CLOSE libère la connexion: jamais avant les messages de fond qui la précèdent
+    if (source == MessageSource::TCP_CLOSE) return LANE_BULK;
+    const char* action;
+    size_t actionLength = findAction(data, length, action);
+    return isRealtimeAction(action, actionLength) ? LANE_REALTIME : LANE_BULK;
+}
 
-      ESP_LOGD(RECEIVE_TAG, "Message ID %i enqueued at queue %u from source: %s: %s at %i", message->msgID, messagesWaiting, source, message->data->c_str(), message->timestamp);
+// Réserve la place d'une trame; false si l'anneau ou les descripteurs sont pleins, en
+// laissant de côté la réserve demandée (descripteurs, octets)
+bool claimIncoming(IncomingLane& r, size_t length, uint8_t& index, uint8_t reserveSlots, uint32_t reserveBytes) {
+    uint32_t need = INCOMING_HEADER + length + 1;
+    bool claimed = false;
+    taskENTER_CRITICAL(&incomingRingMux);
+    if (r.slotsUsed + reserveSlots < r.slotCount && r.used + need + reserveBytes <= r.capacity) {
+        if (r.used == 0) r.head = r.tail = 0;
+        uint32_t at = r.tail;
+        uint32_t skip = 0;
+        bool fits;
+        if (r.tail >= r.head) {
+            // Libre: [tail, fin) puis [0, head); une trame ne chevauche jamais la fin
+            fits = r.capacity - r.tail >= need;
+            if (!fits && r.head >= need) {
+                skip = r.capacity - r.tail;
+                at = 0;
+                fits = true;
+            }
+        } else {
+            fits = r.head - r.tail >= need;
+        }
+        if (fits) {
+            index = r.nextSlot;
+            r.nextSlot = (r.nextSlot + 1) % r.slotCount;
+            r.slotsUsed++;
+            if (r.slotsUsed > r.depthPeak) r.depthPeak = r.slotsUsed;
+            r.tail = (at + need) % r.capacity;
+            r.used += skip + need;
+            if (r.used > r.peak) r.peak = r.used;
+            r.slots[index].offset = at;
+            r.slots[index].end = r.tail;
+            r.slots[index].reserved = skip + need;
+            claimed = true;
+        }
     }
+    taskEXIT_CRITICAL(&incomingRingMux);
+    return claimed;
 }
 
-void processDataFromSocket(const char* action, const JsonObject& message, int64_t timestamp) {
-  ESP_LOGI(RECEIVE_TAG, "Processing action: %s", action);
-  String output = "";
-  serializeJson(message, output);
+// Plus ancienne trame de la voie si sa copie est terminée (tâche de réception)
+IncomingMessage_t* readyIncoming(IncomingLane& r) {
+    IncomingMessage_t& message = r.slots[r.readSlot];
+    return message.ready.load(std::memory_order_acquire) ? &message : nullptr;
+}
 
-  if (output.length() > 0) {
-    ESP_LOGI(RECEIVE_TAG, "Processing message: %i: %s", output.length(), output.c_str());
-  } else {
-    output = "!! NULL !!";
-    ESP_LOGI(RECEIVE_TAG, "Processing null message: %s", output.c_str());
-  }
+// Rend la place de la plus ancienne trame de la voie (tâche de réception)
+void releaseIncoming(IncomingLane& r, IncomingMessage_t& message) {
+    message.ready.store(false, std::memory_order_relaxed);
+    r.readSlot = (r.readSlot + 1) % r.slotCount;
+    taskENTER_CRITICAL(&incomingRingMux);
+    r.head = message.end;
+    r.used -= message.reserved;
+    r.slotsUsed--;
+    taskEXIT_CRITICAL(&incomingRingMux);
+}
+
+const char* incomingPayload(const IncomingLane& r, const IncomingMessage_t& message, size_t& length) {
+    uint16_t prefix;
+    memcpy(&prefix, r.bytes + message.offset, INCOMING_HEADER);
+    length = prefix;
+    return (const char*)r.bytes + message.offset + INCOMING_HEADER;
+}
+
+// Appelée depuis les callbacks réseau: ne bloque jamais, écarte la trame si elle n'est pas admise
+bool enqueueIncomingMessage(MessageSource source, const char* data, size_t length, conn_t conn, uint32_t wsClient) {
+    MessageLane laneId = laneOf(source, data, length);
+    IncomingLane& lane = incomingLanes[laneId];
+    if (length > UINT16_MAX || INCOMING_HEADER + length + 1 > lane.capacity) {
+        ESP_LOGE(RECEIVE_TAG, "Incoming %s frame too large for %s lane (%u bytes), dropped", messageSourceName(source), lane.name, length);
+        lane.dropped++;
+        return false;
+    }
+
+    bool realtime = laneId == LANE_REALTIME;
+    bool admitted = true;
+    if (source == MessageSource::TCP) admitted = admitTcpFrame(conn, realtime);
+    else if (source == MessageSource::WEBSOCKET) admitted = admitWebSocketFrame(wsClient, realtime);
+    if (!admitted) {
+        lane.throttled++;
+        ESP_LOGD(RECEIVE_TAG, "%s frame throttled (%s lane): %.*s", messageSourceName(source), lane.name, (int)length, data);
+        return false;
+    }
+
+    // Seuls les TCP_CLOSE puisent dans la réserve de la voie de fond
+    uint8_t reserveSlots = 0;
+    uint32_t reserveBytes = 0;
+    if (laneId == LANE_BULK && source != MessageSource::TCP_CLOSE) {
+        reserveSlots = INCOMING_CONTROL_SLOTS;
+        reserveBytes = INCOMING_CONTROL_BYTES;
+    }
+    uint8_t index;
+    if (!claimIncoming(lane, length, index, reserveSlots, reserveBytes)) {
+        lane.dropped++;
+        ESP_LOGE(RECEIVE_TAG, "Incoming %s ring full (%u bytes retained), %s frame dropped", lane.name, lane.used, messageSourceName(source));
+        return false;
+    }
+
+    IncomingMessage_t& message = lane.slots[index];
+    uint16_t prefix = length;
+    memcpy(lane.bytes + message.offset, &prefix, INCOMING_HEADER);
+    memcpy(lane.bytes + message.offset + INCOMING_HEADER, data, length);
+    lane.bytes[message.offset + INCOMING_HEADER + length] = '\0';
+    message.source = source;
+    message.conn = conn;
+    message.generation = conn < MAX_TCP_CONNECTIONS ? tcpConnections[conn].generation : 0;
+    message.wsClient = wsClient;
+    message.timestamp = micros();
+    message.msgID = receivedMsgId++;
+
+    ESP_LOGD(RECEIVE_TAG, "Message ID %i enqueued in %s slot %u from source: %s: %.*s at %lld", message.msgID, lane.name, index,
+             messageSourceName(source), (int)length, data, message.timestamp);
+
+    // Le descripteur appartient à la tâche de réception dès qu'il est prêt
+    message.ready.store(true, std::memory_order_release);
+    xSemaphoreGive(incomingReady);
+    return true;
+}
 
+// Découpe un bloc reçu aux '\0' et copie chaque trame directement dans l'anneau.
+// Comme l'ancien découpage, la fin du bloc sans '\0' est une trame complète: buzzers et
+// pages web envoient un message par écriture, sans terminateur.
+void enqueueFrames(MessageSource source, conn_t conn, uint32_t wsClient, const uint8_t* data, size_t len) {
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++) {
+        if (i < len && data[i] != '\0') continue;
+        if (i > start) {
+            enqueueIncomingMessage(source, (const char*)data + start, i - start, conn, wsClient);
+        }
+        start = i + 1;
+    }
+}
+
+void recordLaneLatency(IncomingLane& lane, int64_t timestamp, int64_t dequeued) {
+    uint32_t wait = dequeued - timestamp;
+    uint32_t total = micros() - timestamp;
+    lane.processed++;
+    lane.waitLast = wait;
+    lane.waitTotal += wait;
+    if (wait > lane.waitMax) lane.waitMax = wait;
+    if (total > lane.totalMax) lane.totalMax = total;
+}
+
+// Seaux par source: connexions buzzer ouvertes et clients WebSocket
+void writeAdmissionStats(JsonObject dst) {
+    JsonObject tcp = dst["TCP"].to<JsonObject>();
+    tcp["RATE"] = ADMIT_TCP_RATE;
+    tcp["BURST"] = ADMIT_TCP_BURST;
+    JsonArray connections = tcp["CONNECTIONS"].to<JsonArray>();
+    for (conn_t conn = 0; conn < MAX_TCP_CONNECTIONS; conn++) {
+        const TcpConnection& entry = tcpConnections[conn];
+        if (!entry.open) continue;
+        JsonObject obj = connections.add<JsonObject>();
+        obj["CONN"] = conn;
+        obj["ADMITTED"] = entry.bucket.admitted;
+        obj["THROTTLED"] = entry.bucket.throttled;
+    }
+    writeWebSocketAdmission(dst["WEBSOCKET"].to<JsonObject>());
+}
+
+void writeIncomingStats(JsonObject dst) {
+    for (uint8_t l = 0; l < LANE_COUNT; l++) {
+        const IncomingLane& lane = incomingLanes[l];
+        JsonObject obj = dst[lane.name].to<JsonObject>();
+        obj["CAPACITY"] = lane.capacity;
+        obj["USED"] = lane.used;
+        obj["PEAK"] = lane.peak;
+        obj["DEPTH"] = lane.slotsUsed;
+        obj["DEPTH_PEAK"] = lane.depthPeak;
+        obj["DROPPED"] = lane.dropped;
+        obj["THROTTLED"] = lane.throttled;
+        obj["PROCESSED"] = lane.processed;
+        obj["WAIT_LAST_US"] = lane.waitLast;
+        obj["WAIT_AVG_US"] = lane.processed ? (uint32_t)(lane.waitTotal / lane.processed) : 0;
+        obj["WAIT_MAX_US"] = lane.waitMax;
+        obj["TOTAL_MAX_US"] = lane.totalMax;
+    }
+}
+
+void applyActionBatch(JsonArray actions);
+
+// Applique une action web; false si elle ne demande pas de réécrire la sauvegarde
+bool applyAction(const char* action, const JsonObject& message) {
+  bool persist = true;
+  char idBuffer[12];
   switch (hash(action)) {
     case hash("DELETE"):
       // Handle delete
-      deleteQuestion(message["ID"]);
+      deleteQuestion(idArg(message["ID"], idBuffer, sizeof(idBuffer)));
       break;
       
     case hash("HELLO"):
+      requestFullSnapshot();
       notifyAll();
+      enqueueRanking();
+      enqueueBuzzOrder();
       enqueueOutgoingMessage("QUESTIONS", getQuestions().c_str(), false, nullptr, "");
       break;
       
+    case hash("RESYNC"):
+      // Le client a détecté un trou dans STATE_VERSION
+      requestFullSnapshot();
+      notifyAll();
+      break;
+
     case hash("FULL"):
-      setBumpers(message["bumpers"]);
-      setTeams(message["teams"]);
+      setTeamsAndBumpers(message);
       notifyAll();
       break;
       
@@ -86,7 +441,19 @@ void processDataFromSocket(const char* action, const JsonObject& message, int64_
       break;
 
     case hash("POINTS"):
-      updateScore(message["bumperId"], message["points"]);
+      updateScore(message["bumperId"] | "", message["points"]);
+      // Déjà ajouté au journal des points: pas de réécriture de la sauvegarde
+      persist = false;
+      break;
+
+    case hash("UNDO"):
+      undoScore(message["COUNT"] | 1);
+      persist = false;
+      break;
+
+    case hash("BUZZ_NEXT"):
+      nextBuzzTurn();
+      persist = false;
       break;
 
     case hash("RESET"):
@@ -102,7 +469,7 @@ void processDataFromSocket(const char* action, const JsonObject& message, int64_
       break;
       
     case hash("READY"):
-      readyGame(message["QUESTION"]);
+      readyGame(idArg(message["QUESTION"], idBuffer, sizeof(idBuffer)));
       break;
       
     case hash("START"):
@@ -126,88 +493,271 @@ void processDataFromSocket(const char* action, const JsonObject& message, int64_
       break;
       
     case hash("REMOTE"):
-      setRemotePage(message["REMOTE"]);
+      setRemotePage(message["REMOTE"] | "");
+      break;
+
+    case hash("MOVE_BUMPER"):
+      // Affecte un buzzer de la session courante à une autre
+      moveBumperToSession(message["ID"] | "", parseSession(message["SESSION"]));
       break;
       
     case hash("FSINFO"):
       enqueueOutgoingMessage("FSINFO", ("{\"FSINFO\": \"" + printLittleFSInfo() + "\"}").c_str(), false, nullptr,"");
       break;
+
+    case hash("ACTIONS"):
+      // Lot d'actions: sauvegarde et diffusion faites par le lot
+      applyActionBatch(message["ACTIONS"].as<JsonArray>());
+      persist = false;
+      break;
       
     default:
       ESP_LOGW(RECEIVE_TAG, "Unrecognized action: %s", action);
       break;
   }
-  saveJson();
+  return persist;
+}
+
+//#### LOTS D'ACTIONS ###
+// {"ACTION": "ACTIONS", "MSG": {"ACTIONS": [{"ACTION": "POINTS", "MSG": {...}}, ...]}}
+// Appliqué en entier ou pas du tout, sans publication intermédiaire: une sauvegarde et un
+// UPDATE au plus, sur l'état final (suivi d'un BUZZ_ORDER si la main a changé). Seules les
+// actions qui ne modifient que l'état de la session et ne diffusent rien d'autre y sont admises.
+#define MAX_BATCH_ACTIONS 64
+
+uint32_t batchesApplied = 0;
+uint32_t batchesRejected = 0;
+uint32_t batchedActions = 0;
+uint32_t batchedUpdates = 0;    // UPDATE fondus dans la diffusion de leur lot
+
+bool isBatchableAction(const char* action) {
+  switch (hash(action)) {
+    case hash("UPDATE"):
+    case hash("FULL"):
+    case hash("POINTS"):
+    case hash("UNDO"):
+    case hash("RAZ"):
+    case hash("BUZZ_NEXT"):
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Bumper connu, ou déclaré par un UPDATE/FULL placé plus tôt dans le même lot
+bool isBatchedBumperKnown(JsonArray actions, size_t before, const char* bumperID) {
+  if (findBumperSlot(bumperID) != NO_SLOT) return true;
+  for (size_t i = 0; i < before; i++) {
+    if (actions[i]["MSG"]["bumpers"][bumperID].is<JsonObject>()) return true;
+  }
+  return false;
+}
+
+// Contenu de chaque action du lot, vérifié avant toute modification
+bool isValidBatchedAction(JsonArray actions, size_t index) {
+  JsonVariant entry = actions[index];
+  const char* action = entry["ACTION"] | "";
+  JsonVariant message = entry["MSG"];
+  switch (hash(action)) {
+    case hash("UPDATE"):
+      return message.is<JsonObject>()
+          && (message["teams"].isNull() || message["teams"].is<JsonObject>())
+          && (message["bumpers"].isNull() || message["bumpers"].is<JsonObject>());
+    case hash("FULL"):
+      return message["teams"].is<JsonObject>() && message["bumpers"].is<JsonObject>();
+    case hash("POINTS"): {
+      const char* bumperID = message["bumperId"] | "";
+      if (bumperID[0] == '\0' || !message["points"].is<int>()) return false;
+      if (!isBatchedBumperKnown(actions, index, bumperID)) {
+        ESP_LOGE(RECEIVE_TAG, "Unknown bumper %s in ACTIONS batch", bumperID);
+        return false;
+      }
+      return true;
+    }
+    case hash("UNDO"):
+      return message["COUNT"].isNull() || (message["COUNT"].is<int>() && message["COUNT"].as<int>() > 0);
+    default:
+      // RAZ, BUZZ_NEXT: sans contenu
+      return true;
+  }
+}
+
+void applyActionBatch(JsonArray actions) {
+  size_t count = actions.size();
+  // Tout est vérifié avant la première modification: noms puis contenus
+  bool valid = count > 0 && count <= MAX_BATCH_ACTIONS;
+  for (size_t i = 0; valid && i < count; i++) {
+    const char* action = actions[i]["ACTION"] | "";
+    if (!isBatchableAction(action)) {
+      ESP_LOGE(RECEIVE_TAG, "Action %s not allowed in ACTIONS batch", action);
+      valid = false;
+    } else if (!isValidBatchedAction(actions, i)) {
+      ESP_LOGE(RECEIVE_TAG, "Invalid %s payload at #%u in ACTIONS batch", action, i);
+      valid = false;
+    }
+  }
+  if (!valid) {
+    batchesRejected++;
+    ESP_LOGE(RECEIVE_TAG, "ACTIONS batch of %u rejected, nothing applied", count);
+    return;
+  }
+
+  uint32_t from = getStateVersion();
+  StateBatch batch;
+  activeBatch = &batch;
+  beginLedgerBatch();
+  bool persist = false;
+  for (JsonVariant entry : actions) {
+    const char* action = entry["ACTION"] | "";
+    ESP_LOGD(RECEIVE_TAG, "Batched action: %s", action);
+    persist = applyAction(action, entry["MSG"].as<JsonObject>()) || persist;
+  }
+  // Points et annulations du lot: une seule écriture du journal
+  commitLedgerBatch();
+  activeBatch = nullptr;
+
+  batchesApplied++;
+  batchedActions += count;
+  if (persist || batch.save) requestSave();
+  if (batch.updates > 0 || getStateVersion() != from) {
+    batchedUpdates += batch.updates;
+    enqueueStateUpdate(batchEnvelope(batch).c_str(), batch.notify);
+  }
+  if (batch.buzzOrder) {
+    enqueueBuzzOrder();
+  }
+  ESP_LOGI(RECEIVE_TAG, "ACTIONS batch of %u applied, state %u -> %u, %u updates folded into one",
+           count, from, getStateVersion(), batch.updates);
+}
+
+void writeBatchStats(JsonObject dst) {
+  dst["APPLIED"] = batchesApplied;
+  dst["REJECTED"] = batchesRejected;
+  dst["ACTIONS"] = batchedActions;
+  dst["UPDATES_FOLDED"] = batchedUpdates;
+}
+
+void processDataFromSocket(const char* action, const JsonObject& message, int64_t timestamp) {
+  ESP_LOGI(RECEIVE_TAG, "Processing action: %s", action);
+  String output = "";
+  serializeJson(message, output);
+
+  if (output.length() > 0) {
+    ESP_LOGI(RECEIVE_TAG, "Processing message: %i: %s", output.length(), output.c_str());
+  } else {
+    output = "!! NULL !!";
+    ESP_LOGI(RECEIVE_TAG, "Processing null message: %s", output.c_str());
+  }
+
+  if (applyAction(action, message)) {
+    requestSave();
+  }
 }
 
 // Déclaration externe de la fonction définie dans BumperServer.h
-extern void processButtonPress(const String& bumperID, const char* b_team, int64_t b_time, String b_button);
+extern void processButtonPress(slot_t bumper, int64_t b_time, const char* b_button);
 
-void processTCPMessage(const String& data, AsyncClient* client, int64_t timestamp) {
-    JsonDocument receivedData;
-    DeserializationError error = deserializeJson(receivedData, data);
+void processTCPMessage(const char* data, size_t length, AsyncClient* client, uint32_t connTag, int64_t timestamp) {
+    // Mesure d'un appui: de la trame reçue à la mise en file des diffusions et à la demande
+    // de sauvegarde, soit toute la fonction
+    AllocProbeScope probe;
+    JsonDocument receivedData(taskJsonAllocator());
+    DeserializationError error = deserializeJson(receivedData, data, length);
     if (error) {
         ESP_LOGE(RECEIVE_TAG, "Failed to parse JSON from TCP: %s", error.c_str());
         return;
     }
 
-    String bumperID = receivedData["ID"].as<String>();
-    String versionBuzzer = receivedData["VERSION"].as<String>();
-    String action = receivedData["ACTION"].as<String>();
+    const char* bumperID = receivedData["ID"] | "";
+    const char* versionBuzzer = receivedData["VERSION"] | "";
+    const char* action = receivedData["ACTION"] | "";
     JsonObject MSG = receivedData["MSG"];
 
     ESP_LOGD(RECEIVE_TAG, "TCP message: bumperID=%s version=%s ACTION=%s", 
-             bumperID.c_str(), versionBuzzer.c_str(), action.c_str());
+             bumperID, versionBuzzer, action);
+
+    // Session du buzzer: celle qui connaît sa connexion ou sa MAC (0 pour un inconnu).
+    // Un HELLO peut demander une autre session: le buzzer y est déplacé.
+    session_t session = findBumperSession(bumperID, client);
+    if (strcmp(action, "HELLO") == 0) {
+        session_t requested = parseSession(MSG["SESSION"]);
+        MSG.remove("SESSION");
+        if (session == NO_SESSION) {
+            session = requested;
+        } else if (requested != NO_SESSION && requested != session) {
+            SessionScope from(session);
+            if (moveBumperToSession(bumperID, requested)) {
+                requestSave();
+                session = requested;
+            }
+        }
+    }
+    SessionScope scope(session);
+    // Sauvegarde seulement si la trame a changé l'état persisté (pas RESYNC ni un PONG sans effet)
+    bool persist = false;
+
+    // Résolution du buzzer: par connexion, sinon par MAC (HELLO crée le slot)
+    slot_t slot = findBumperSlotByClient(client);
+    if (slot == NO_SLOT || strcmp(bumperIdOf(slot), bumperID) != 0) {
+        slot = findBumperSlot(bumperID);
+    }
     
     // Utiliser if-else au lieu de switch pour éviter les problèmes de sauts
-    if (action == "HELLO") {
+    if (strcmp(action, "HELLO") == 0) {
         // Handle hello action
-        updateBumper(bumperID.c_str(), MSG);
+        updateBumper(bumperID, MSG);
+        slot = findBumperSlot(bumperID);
+        persist = true;
+        requestFullSnapshot();
+        notifyAll();
+        sendBumperSession(client);
+    }
+    else if (strcmp(action, "RESYNC") == 0) {
+        ESP_LOGI(RECEIVE_TAG, "Bumper %s requested full state", bumperID);
+        requestFullSnapshot();
         notifyAll();
     }
-    else if (action == "BUTTON") {
+    else if (strcmp(action, "BUTTON") == 0) {
         // Handle button action
-        ESP_LOGE(RECEIVE_TAG, "Button pressed: %s", bumperID.c_str());
-        JsonObject bumper = getBumper(bumperID.c_str());
-        const char* teamID = bumper["TEAM"];
-        String b_button = MSG["button"];
-        if (teamID != nullptr) {
-            processButtonPress(bumperID, teamID, timestamp, b_button);
+        ESP_LOGD(RECEIVE_TAG, "Button pressed: %s", bumperID);
+        if (slot != NO_SLOT && gameStore().bumperHot[slot].team != NO_SLOT) {
+            probe.measure("BUTTON");
+            processButtonPress(slot, timestamp, MSG["button"] | "");
+            persist = true;
 //            pauseGame(client);
 
         }
     }
-    else if (action == "PONG") {
+    else if (strcmp(action, "PONG") == 0) {
         // Handle ping response
-        ESP_LOGI(RECEIVE_TAG, "Bumper PONG received from: %s", bumperID.c_str());
-        if (isGamePrepare()) {
-          if (xSemaphoreTake(updateMutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            setBumperReady(bumperID.c_str());
-            updateTeamsReady();
-            //notifyAll();
-            sleep(1);
-            // Check if all teams are ready to potentially transition to READY state
-            if (areAllTeamsReady()) {
-                ESP_LOGI(RECEIVE_TAG, "All teams are ready to start");
-                setGamePhase("READY");
-                enqueueOutgoingMessage("READY", getTeamsAndBumpersJSON().c_str(), false, nullptr,"");
+        ESP_LOGI(RECEIVE_TAG, "Bumper PONG received from: %s", bumperID);
+        if (isGamePrepare() && slot != NO_SLOT) {
+            // Compteurs incrémentaux: READY part dès la réponse du dernier buzzer
+            if (setBumperReadySlot(slot)) {
+                persist = true;
+                if (areAllTeamsReady()) {
+                    ESP_LOGI(RECEIVE_TAG, "All teams are ready to start");
+                    fireGamePhase(PhaseEvent::READY);
+                }
+                enqueueStateUpdate();
             }
-            enqueueOutgoingMessage("UPDATE", getTeamsAndBumpersJSON().c_str(), false, nullptr,"");
-            xSemaphoreGive(updateMutex);
-          } else {
-            ESP_LOGI(RECEIVE_TAG, "Couldn't obtain mutex in processTCPMessage");
-          }
         }
     }
     else {
-        ESP_LOGW(RECEIVE_TAG, "Unknown TCP action: %s", action.c_str());
+        ESP_LOGW(RECEIVE_TAG, "Unknown TCP action: %s", action);
+    }
+
+    if (slot != NO_SLOT) {
+        bindBumperClient(slot, client, connTag);
+    }
+    if (persist) {
+        requestSave();
     }
-    saveJson();
 }
 
-void processWebSocketMessage(const String& data, int64_t timestamp) {
-    JsonDocument receivedData;
-    DeserializationError error = deserializeJson(receivedData, data);
+void processWebSocketMessage(const char* data, size_t length, uint32_t wsClient, int64_t timestamp) {
+    JsonDocument receivedData(taskJsonAllocator());
+    DeserializationError error = deserializeJson(receivedData, data, length);
     if (error) {
         ESP_LOGE(RECEIVE_TAG, "Failed to parse JSON from WebSocket: %s", error.c_str());
         return;
@@ -218,37 +768,122 @@ void processWebSocketMessage(const String& data, int64_t timestamp) {
         return;
     }
 
-    const char* action = receivedData["ACTION"];
+    const char* action = receivedData["ACTION"] | "";
     JsonObject message = receivedData["MSG"].as<JsonObject>();
 
+    // HELLO choisit la session du client web; tous ses messages y sont ensuite traités
+    if (strcmp(action, "HELLO") == 0) {
+        session_t requested = parseSession(message["SESSION"]);
+        if (requested != NO_SESSION) setWebClientSession(wsClient, requested);
+    }
+    SessionScope scope(webClientSession(wsClient));
+
     // Le message est déjà validé, le traiter directement
     processDataFromSocket(action, message, timestamp);
 }
 
+void processIncoming(IncomingLane& lane, IncomingMessage_t& receivedMessage) {
+    int64_t dequeued = micros();
+    size_t length;
+    const char* data = incomingPayload(lane, receivedMessage, length);
+    ESP_LOGI(RECEIVE_TAG, "dequeue message %i from %s (%s lane) : %s", receivedMessage.msgID,
+             messageSourceName(receivedMessage.source), lane.name, data);
+
+    // Traiter le message selon sa source, sur place dans l'anneau
+    switch (receivedMessage.source) {
+        case MessageSource::TCP: {
+            AsyncClient* client = connectionClient(receivedMessage.conn, receivedMessage.generation);
+            if (client == nullptr) {
+                ESP_LOGW(RECEIVE_TAG, "Message %i from closed connection %u ignored", receivedMessage.msgID, receivedMessage.conn);
+                break;
+            }
+            processTCPMessage(data, length, client, connectionTag(receivedMessage.conn, receivedMessage.generation),
+                              receivedMessage.timestamp);
+            break;
+        }
+        case MessageSource::TCP_CLOSE: {
+            AsyncClient* client = releaseConnection(receivedMessage.conn, receivedMessage.generation);
+            if (client == nullptr) break;
+            uint32_t tag = connectionTag(receivedMessage.conn, receivedMessage.generation);
+            for (session_t session = 0; session < MAX_SESSIONS; session++) {
+                SessionScope scope(session);
+                unbindBumperClient(client, tag);
+            }
+            break;
+        }
+        case MessageSource::WEBSOCKET:
+            processWebSocketMessage(data, length, receivedMessage.wsClient, receivedMessage.timestamp);
+            break;
+    }
+
+    recordLaneLatency(lane, receivedMessage.timestamp, dequeued);
+    const char* action = "TCP_CLOSE";
+    size_t actionLength = strlen(action);
+    if (receivedMessage.source != MessageSource::TCP_CLOSE) actionLength = findAction(data, length, action);
+    ActionMetrics* metrics = actionMetrics(receiveMetrics, action, actionLength);
+    recordStage(metrics, STAGE_WAIT, dequeued - receivedMessage.timestamp);
+    recordStage(metrics, STAGE_PROCESS, micros() - dequeued);
+    releaseIncoming(lane, receivedMessage);
+    receiveArena.reset();
+    receiveArena.logUsage();
+}
+
+// Commande postée par un autre contexte, exécutée ici comme un message
+void runGameCommand(const GameCommand& command) {
+    int64_t dequeued = micros();
+    ESP_LOGI(RECEIVE_TAG, "Game command %s (session %u)", gameCommandName(command.type), command.session);
+    {
+        SessionScope scope(command.session);
+        applyGameCommand(command);
+    }
+    const char* name = gameCommandName(command.type);
+    ActionMetrics* metrics = actionMetrics(receiveMetrics, name, strlen(name));
+    // Posée depuis une ISR: pas d'horodatage, pas d'attente mesurée
+    if (command.postedAt != 0) recordStage(metrics, STAGE_WAIT, dequeued - command.postedAt);
+    recordStage(metrics, STAGE_PROCESS, micros() - dequeued);
+    receiveArena.reset();
+}
+
 void receiveMessageTask(void *parameter) {
-    IncomingMessage_t* receivedMessage;
+    bindTaskArena(&receiveArena);
     while (1) {
-      UBaseType_t messagesWaitingBefore = uxQueueMessagesWaiting(incomingQueue);
-
-        ESP_LOGD(RECEIVE_TAG, "Waiting for incoming messages (%u inqueue)", messagesWaitingBefore);
-        if (xQueueReceive(incomingQueue, &receivedMessage, portMAX_DELAY)) {
-            ESP_LOGI(RECEIVE_TAG, "dequeue message %i from %s : %s", receivedMessage->msgID,
-                     receivedMessage->source.c_str(), receivedMessage->data->c_str());
-            
-            // Traiter le message selon sa source
-            if (receivedMessage->source == "TCP") {
-                processTCPMessage(*(receivedMessage->data), receivedMessage->client, receivedMessage->timestamp);
-            } 
-            else if (receivedMessage->source == "WebSocket") {
-                processWebSocketMessage(*(receivedMessage->data), receivedMessage->timestamp);
-            }
-            else {
-                ESP_LOGW(RECEIVE_TAG, "Unknown message source: %s", receivedMessage->source.c_str());
+        ESP_LOGD(RECEIVE_TAG, "Waiting for incoming messages (%u realtime, %u bulk inqueue)",
+                 incomingLanes[LANE_REALTIME].slotsUsed, incomingLanes[LANE_BULK].slotsUsed);
+        if (xSemaphoreTake(incomingReady, portMAX_DELAY) != pdTRUE) continue;
+
+        // Tout ce qui est prêt; une trame encore en copie sera signalée par son propre jeton.
+        // Un appui passe devant les commandes (timer, HTTP), qui passent devant le fond.
+        while (1) {
+            IncomingLane& realtime = incomingLanes[LANE_REALTIME];
+            IncomingLane& bulk = incomingLanes[LANE_BULK];
+            IncomingMessage_t* message = readyIncoming(realtime);
+            GameCommand command;
+            if (message != nullptr) {
+                processIncoming(realtime, *message);
+            } else if (xQueueReceive(gameCommands, &command, 0) == pdTRUE) {
+                runGameCommand(command);
+            } else if ((message = readyIncoming(bulk)) != nullptr) {
+                processIncoming(bulk, *message);
+            } else {
+                break;
             }
-            
-            // Nettoyage
-            delete receivedMessage->data;
-            delete receivedMessage;
         }
     }
-}
\ No newline at end of file
+}
+
+//#### METRIQUES ###
+// /metrics et push METRICS: attente, traitement et envoi par action, profondeur des files
+void writeMetrics(JsonObject dst) {
+    writeLatencyBounds(dst["BUCKETS_US"].to<JsonArray>());
+    JsonObject receive = dst["RECEIVE"].to<JsonObject>();
+    writeIncomingStats(receive["LANES"].to<JsonObject>());
+    writeAdmissionStats(receive["ADMISSION"].to<JsonObject>());
+    writeBatchStats(receive["BATCHES"].to<JsonObject>());
+    writeGameCommandStats(receive["COMMANDS"].to<JsonObject>());
+    writePipelineMetrics(receiveMetrics, receive);
+    JsonObject send = dst["SEND"].to<JsonObject>();
+    send["DEPTH"] = uxQueueMessagesWaiting(outgoingQueue);
+    send["DEPTH_PEAK"] = outgoingDepthPeak;
+    send["DROPPED"] = outgoingDropped;
+    writePipelineMetrics(sendMetrics, send);
+}
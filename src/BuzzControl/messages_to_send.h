@@ -1,6 +1,9 @@
 #pragma once
 #include "Common/CustomLogger.h"
 #include "Common/led.h"
+#include "Common/jsonArena.h"
+#include "pipelineMetrics.h"
+#include "stateBatch.h"
 
 #include <ArduinoJson.h>
 #include <freertos/FreeRTOS.h>
@@ -9,70 +12,336 @@
 // Configuration
 const char* SEND_TAG = "MSG_SEND";
 int sentMsgId=0;
+// Arène des documents JSON de la tâche d'envoi (deltas d'état)
+JsonArena sendArena("send", 8 * 1024);
 
 // Structure de message pour les envois
 typedef struct {
     String action;
-    String* message;  
-    String* update;  
+    String message;
+    String update;
     bool notifyAll;
     AsyncClient* client;
     int msgID;
-    String* msgTime;
+    int64_t enqueuedAt; // micros() à la mise en file
+    bool stateUpdate;   // payload construit à l'envoi: delta d'état depuis la dernière diffusion
+    session_t session;  // session de l'émetteur: état diffusé et destinataires
 } OutgoingMessage_t;
 
 // Queue pour les messages sortants
 QueueHandle_t outgoingQueue;
+UBaseType_t outgoingDepthPeak = 0;
+uint32_t outgoingDropped = 0;
+
+void trackOutgoingDepth() {
+    UBaseType_t depth = uxQueueMessagesWaiting(outgoingQueue);
+    if (depth > outgoingDepthPeak) outgoingDepthPeak = depth;
+}
+
+// Descripteurs préalloués: la mise en file n'alloue rien tant que les chaînes tiennent dans
+// leur réserve. La tâche d'envoi rend le descripteur après l'envoi.
+#define OUTGOING_QUEUE_LENGTH 20
+#define OUTGOING_SLOTS (OUTGOING_QUEUE_LENGTH + 4)   // file + message en cours + marge
+#define OUTGOING_TEXT_RESERVE 512
+#define OUTGOING_TEXT_KEEP 2048     // au-delà, la chaîne est rendue au tas à la libération
+
+OutgoingMessage_t outgoingPool[OUTGOING_SLOTS];
+QueueHandle_t outgoingFree;
+
+// Réserve initiale, reprise si un gros message a été rendu au tas
+void reserveOutgoingMessage(OutgoingMessage_t* message) {
+    message->action.reserve(24);
+    message->message.reserve(OUTGOING_TEXT_RESERVE);
+    message->update.reserve(64);
+}
+
+void clearOutgoingText(String& text) {
+    if (text.length() > OUTGOING_TEXT_KEEP) {
+        text = String();
+    } else {
+        text = "";
+    }
+}
+
+// Depuis l'écrivain: attend comme l'envoi dans la file, nullptr si le pool reste vide
+OutgoingMessage_t* acquireOutgoingMessage() {
+    OutgoingMessage_t* message = nullptr;
+    if (xQueueReceive(outgoingFree, &message, pdMS_TO_TICKS(100)) != pdPASS) {
+        ESP_LOGE(SEND_TAG, "No free outgoing message descriptor");
+        outgoingDropped++;
+        return nullptr;
+    }
+    return message;
+}
+
+void freeOutgoingMessage(OutgoingMessage_t* message) {
+    clearOutgoingText(message->action);
+    clearOutgoingText(message->message);
+    clearOutgoingText(message->update);
+    reserveOutgoingMessage(message);
+    xQueueSend(outgoingFree, &message, 0);
+}
 
 // Initialisation de la queue de messages sortants
 void initOutgoingQueue() {
-    outgoingQueue = xQueueCreate(20, sizeof(OutgoingMessage_t*));
-    if (outgoingQueue == NULL) {
+    outgoingQueue = xQueueCreate(OUTGOING_QUEUE_LENGTH, sizeof(OutgoingMessage_t*));
+    outgoingFree = xQueueCreate(OUTGOING_SLOTS, sizeof(OutgoingMessage_t*));
+    if (outgoingQueue == NULL || outgoingFree == NULL) {
         ESP_LOGE(SEND_TAG, "Failed to create outgoing message queue");
+        return;
+    }
+    for (uint8_t i = 0; i < OUTGOING_SLOTS; i++) {
+        OutgoingMessage_t* message = &outgoingPool[i];
+        reserveOutgoingMessage(message);
+        xQueueSend(outgoingFree, &message, 0);
     }
-}
-
-void notifyAll() {
-    String output= getTeamsAndBumpersJSON();
-    
-        sendMessageToAllClients("UPDATE", output.c_str());
 }
 
 void enqueueOutgoingMessage(const char* action, const char* msg, bool notify, AsyncClient* client, const char* update) {
-    OutgoingMessage_t* message = new OutgoingMessage_t;
+    if (notify) {
+        publishSnapshot();  // le notifyAll qui suit est construit sur cet état
+    }
+    OutgoingMessage_t* message = acquireOutgoingMessage();
+    if (message == nullptr) return;
+    message->stateUpdate = false;
     message->action = action;
-    message->message = new String(msg);
-    message->update = new String(update);
-    message->msgTime = new String(micros());
+    message->message = msg;
+    message->update = update;
+    message->enqueuedAt = micros();
     message->msgID = sentMsgId++;
     message->notifyAll = notify;
     message->client = client;
+    message->session = currentSession();
 
     if (xQueueSend(outgoingQueue, &message, pdMS_TO_TICKS(100)) != pdPASS) {
         ESP_LOGE(SEND_TAG, "Failed to send message to outgoing queue");
-        delete message->message;
-        delete message->msgTime;
-        delete message->update;
-        delete message;
+        outgoingDropped++;
+        freeOutgoingMessage(message);
     } else {
         UBaseType_t messagesWaiting = uxQueueMessagesWaiting(outgoingQueue);
+        trackOutgoingDepth();
 
         ESP_LOGD(SEND_TAG, "Message ID %i enqueued as %u %s : %s => %s", message->msgID, messagesWaiting, message->action.c_str(), msg, update);
     }
 }
 
-String makeJsonMessage(const String& action, const String& msg, const String& update) {
-    String message = "{";
-    message += "\"ACTION\": \"" + action + "\"";
-    message += ", \"VERSION\": \"" + String(VERSION) + "\"";
-    if (update != "") { message += "," + update + "";};
-    message += ", \"MSG\":" + msg + "";
-    message += ", \"TIME_EVENT\":" + String(micros()) + "";
-    message += "} \n\0";
+// Classement publié par l'écrivain; destiné aux clients web uniquement
+void enqueueRanking() {
+    enqueueOutgoingMessage("RANKING", publishRanking().c_str(), false, nullptr, "");
+}
 
-    return message;
+// Ordre des appuis de la manche, pour les clients web; dans un lot, diffusé une fois à la fin
+void enqueueBuzzOrder() {
+    if (activeBatch != nullptr) {
+        activeBatch->buzzOrder = true;
+        return;
+    }
+    enqueueOutgoingMessage("BUZZ_ORDER", publishBuzzOrder().c_str(), false, nullptr, "");
+}
+
+// Messages d'affichage sans intérêt pour les buzzers: pas de broadcast UDP
+bool isWebOnlyAction(const String& action) {
+    return action == "RANKING" || action == "BUZZ_ORDER" || action == "METRICS";
 }
 
+// UPDATE d'état: publié ici par l'écrivain, le delta est calculé par la tâche d'envoi sur le snapshot
+void enqueueStateUpdate(const char* update, bool notify) {
+    // Lot en cours: un seul UPDATE, à la fin du lot
+    if (activeBatch != nullptr) {
+        activeBatch->updates++;
+        activeBatch->notify = activeBatch->notify || notify;
+        // Les enveloppes d'un lot passent par enqueuePointsUpdate/enqueueUndoUpdate
+        if (update[0] != '\0') ESP_LOGW(SEND_TAG, "Envelope dropped in batch: %s", update);
+        return;
+    }
+    publishSnapshot();
+    OutgoingMessage_t* message = acquireOutgoingMessage();
+    if (message == nullptr) return;
+    message->stateUpdate = true;
+    message->action = "UPDATE";
+    message->update = update;
+    message->enqueuedAt = micros();
+    message->msgID = sentMsgId++;
+    message->notifyAll = notify;
+    message->client = nullptr;
+    message->session = currentSession();
+
+    if (xQueueSend(outgoingQueue, &message, pdMS_TO_TICKS(100)) != pdPASS) {
+        ESP_LOGE(SEND_TAG, "Failed to send state update to outgoing queue");
+        outgoingDropped++;
+        freeOutgoingMessage(message);
+    } else {
+        trackOutgoingDepth();
+        ESP_LOGD(SEND_TAG, "State update ID %i enqueued", message->msgID);
+    }
+    // Le classement suit les scores: rediffusé seulement s'il a changé
+    if (isRankingChanged()) {
+        enqueueRanking();
+    }
+}
+
+void notifyAll() {
+    enqueueStateUpdate();
+}
+
+// UPDATE portant une attribution ("award": objet POINTS). Dans un lot, chaque attribution
+// est gardée; l'UPDATE du lot les diffuse en tableau.
+void enqueuePointsUpdate(const char* award) {
+    if (activeBatch != nullptr) {
+        if (activeBatch->points.length() > 0) activeBatch->points += ", ";
+        activeBatch->points += award;
+        enqueueStateUpdate();
+        return;
+    }
+    char update[288];
+    snprintf(update, sizeof(update), "\"POINTS\": %s", award);
+    enqueueStateUpdate(update);
+}
+
+// UPDATE portant une annulation; dans un lot, les annulations sont cumulées
+void enqueueUndoUpdate(int undone, uint32_t seq) {
+    if (activeBatch != nullptr) {
+        activeBatch->undone += undone;
+        activeBatch->undoSeq = seq;
+        enqueueStateUpdate();
+        return;
+    }
+    char update[64];
+    snprintf(update, sizeof(update), "\"UNDO\": {\"count\": %d, \"seq\": %lu}", undone, (unsigned long)seq);
+    enqueueStateUpdate(update);
+}
+
+// Enveloppe de l'UPDATE d'un lot: "POINTS": [...] et "UNDO": {...}, s'il y en a
+String batchEnvelope(const StateBatch& batch) {
+    String envelope;
+    if (batch.points.length() > 0) {
+        envelope = "\"POINTS\": [" + batch.points + "]";
+    }
+    if (batch.undone > 0) {
+        char undo[64];
+        snprintf(undo, sizeof(undo), "\"UNDO\": {\"count\": %d, \"seq\": %lu}", batch.undone, (unsigned long)batch.undoSeq);
+        if (envelope.length() > 0) envelope += ", ";
+        envelope += undo;
+    }
+    return envelope;
+}
+
+//#### ENCODAGE DES TRAMES ###
+// Tampon de sortie de la tâche d'envoi, réutilisé d'une trame à l'autre. La longueur de la
+// trame est calculée d'abord; le tampon n'est agrandi que si elle dépasse la plus grande vue,
+// puis enveloppe et payload y sont copiés une seule fois.
+// {"ACTION": "<action>", "VERSION": "<v>", "SESSION": <n>[,<update>], "MSG":<msg>, "TIME_EVENT":<µs>} \n
+struct FrameEncoder {
+    char* buffer = nullptr;
+    size_t capacity = 0;
+    uint32_t frames = 0;
+    uint32_t grows = 0;
+    size_t peak = 0;            // plus grande trame
+    uint32_t lastMicros = 0;    // durée du dernier encodage
+    uint32_t maxMicros = 0;
+    uint32_t shared = 0;        // diffusions encodées une fois dans un tampon partagé
+    uint32_t fanout = 0;        // clients WebSocket servis par ces tampons
+    uint32_t copied = 0;        // diffusions copiées par client, tous les tampons encore en file
+};
+
+FrameEncoder frameEncoder;
+
+bool reserveFrame(FrameEncoder& encoder, size_t length) {
+    if (length + 1 <= encoder.capacity) return true;
+    size_t capacity = encoder.capacity ? encoder.capacity : 1024;
+    while (capacity < length + 1) capacity *= 2;
+    char* grown = (char*)realloc(encoder.buffer, capacity);
+    if (grown == nullptr) {
+        ESP_LOGE(SEND_TAG, "Unable to grow frame buffer to %u bytes", capacity);
+        return false;
+    }
+    encoder.buffer = grown;
+    encoder.capacity = capacity;
+    encoder.grows++;
+    return true;
+}
+
+static inline char* putBytes(char* out, const char* data, size_t length) {
+    memcpy(out, data, length);
+    return out + length;
+}
+
+// Parties variables d'une trame, figées une fois: toutes les copies portent le même TIME_EVENT
+struct FrameHeader {
+    char session[4];
+    size_t sessionLength;
+    char timeEvent[12];
+    size_t timeLength;
+    uint32_t start;     // micros() au début de l'encodage
+};
+
+static const char FRAME_ACTION_KEY[] = "{\"ACTION\": \"";
+static const char FRAME_VERSION_KEY[] = "\", \"VERSION\": \"" VERSION "\", \"SESSION\": ";
+static const char FRAME_MSG_KEY[] = ", \"MSG\":";
+static const char FRAME_TIME_KEY[] = ", \"TIME_EVENT\":";
+static const char FRAME_END[] = "} \n";
+
+// Fige session et TIME_EVENT, retourne la longueur exacte de la trame
+size_t prepareFrame(FrameHeader& header, const String& action, const String& msg, const String& update) {
+    header.start = micros();
+    header.sessionLength = snprintf(header.session, sizeof(header.session), "%u", currentSession());
+    header.timeLength = snprintf(header.timeEvent, sizeof(header.timeEvent), "%lu", (unsigned long)micros());
+    return sizeof(FRAME_ACTION_KEY) - 1 + action.length() + sizeof(FRAME_VERSION_KEY) - 1 + header.sessionLength
+         + (update.length() ? 1 + update.length() : 0)
+         + sizeof(FRAME_MSG_KEY) - 1 + msg.length() + sizeof(FRAME_TIME_KEY) - 1 + header.timeLength + sizeof(FRAME_END) - 1;
+}
+
+// Écrit exactement prepareFrame() octets dans out
+void writeFrame(char* out, const FrameHeader& header, const String& action, const String& msg, const String& update, size_t length) {
+    out = putBytes(out, FRAME_ACTION_KEY, sizeof(FRAME_ACTION_KEY) - 1);
+    out = putBytes(out, action.c_str(), action.length());
+    out = putBytes(out, FRAME_VERSION_KEY, sizeof(FRAME_VERSION_KEY) - 1);
+    out = putBytes(out, header.session, header.sessionLength);
+    if (update.length()) {
+        *out++ = ',';
+        out = putBytes(out, update.c_str(), update.length());
+    }
+    out = putBytes(out, FRAME_MSG_KEY, sizeof(FRAME_MSG_KEY) - 1);
+    out = putBytes(out, msg.c_str(), msg.length());
+    out = putBytes(out, FRAME_TIME_KEY, sizeof(FRAME_TIME_KEY) - 1);
+    out = putBytes(out, header.timeEvent, header.timeLength);
+    putBytes(out, FRAME_END, sizeof(FRAME_END) - 1);
+
+    frameEncoder.frames++;
+    if (length > frameEncoder.peak) frameEncoder.peak = length;
+    frameEncoder.lastMicros = micros() - header.start;
+    if (frameEncoder.lastMicros > frameEncoder.maxMicros) frameEncoder.maxMicros = frameEncoder.lastMicros;
+}
+
+// Trame encodée dans frameEncoder.buffer (valable jusqu'au prochain encodage), nullptr si
+// le tampon n'a pas pu être agrandi
+const char* encodeFrame(const String& action, const String& msg, const String& update, size_t& length) {
+    FrameHeader header;
+    length = prepareFrame(header, action, msg, update);
+    if (!reserveFrame(frameEncoder, length)) {
+        length = 0;
+        return nullptr;
+    }
+    writeFrame(frameEncoder.buffer, header, action, msg, update, length);
+    frameEncoder.buffer[length] = '\0';
+    return frameEncoder.buffer;
+}
+
+void writeEncoderStats(JsonObject dst) {
+    dst["FRAMES"] = frameEncoder.frames;
+    dst["CAPACITY"] = frameEncoder.capacity;
+    dst["GROWS"] = frameEncoder.grows;
+    dst["PEAK"] = frameEncoder.peak;
+    dst["LAST_US"] = frameEncoder.lastMicros;
+    dst["MAX_US"] = frameEncoder.maxMicros;
+    dst["SHARED"] = frameEncoder.shared;
+    dst["FANOUT"] = frameEncoder.fanout;
+    dst["COPIED"] = frameEncoder.copied;
+}
+
+// Temps passé à remettre les trames au réseau (files WebSocket, TCP, UDP) pour le message en cours
+uint32_t radioMicros = 0;
+
 // Fonction générique pour calculer l'adresse de broadcast
 IPAddress calculateBroadcast(const IPAddress& ip, const IPAddress& subnet) {
     IPAddress broadcast;
@@ -84,18 +353,22 @@ IPAddress calculateBroadcast(const IPAddress& ip, const IPAddress& subnet) {
 
 void sendMessageToClient(const String& action, const String& msg, const String& update, AsyncClient* client) {
     if (client && client->connected()) {
-        String message = makeJsonMessage(action, msg, update);
-        client->write(message.c_str(), message.length());
-        ESP_LOGI(SEND_TAG, "Sent to %s: %s", client->remoteIP().toString().c_str(), message.c_str());
+        size_t length;
+        const char* message = encodeFrame(action, msg, update, length);
+        if (message == nullptr) return;
+        uint32_t start = micros();
+        client->write(message, length);
+        radioMicros += micros() - start;
+        ESP_LOGI(SEND_TAG, "Sent to %s: %s", client->remoteIP().toString().c_str(), message);
     } else {
         ESP_LOGW(SEND_TAG, "Client not connected or null");
     }
 }
 
-bool sendBroadcastUDP(const String& action, const String& msg, const String& update) {
+// Trame déjà encodée (tampon partagé avec les clients WebSocket)
+bool sendBroadcastUDP(const String& action, const char* message, size_t length) {
   ESP_LOGI(SEND_TAG, "Sending broadcast message: %s", action.c_str());
-  String message = makeJsonMessage(action, msg, update);
-  ESP_LOGD(SEND_TAG, "Broadcasting message: %s", message.c_str());
+  ESP_LOGD(SEND_TAG, "Broadcasting message: %.*s", (int)length, message);
 
   bool success = false;
   WiFiUDP udp;
@@ -117,15 +390,15 @@ bool sendBroadcastUDP(const String& action, const String& msg, const String& upd
   if (WiFi.status() == WL_CONNECTED) {
     for (int attempt = 0; attempt < maxRetries; attempt++) {
       if (udp.beginPacket(staBroadcast, configManager.getControllerPort())) {
-        size_t bytesSent = udp.write((const uint8_t*)message.c_str(), message.length());
-        if (bytesSent == message.length() && udp.endPacket()) {
+        size_t bytesSent = udp.write((const uint8_t*)message, length);
+        if (bytesSent == length && udp.endPacket()) {
           ESP_LOGI(SEND_TAG, "UDP broadcast sent successfully on STA network to %s (%d bytes)", 
                   staBroadcast.toString().c_str(), bytesSent);
           success = true;
           break;
         } else {
           ESP_LOGW(SEND_TAG, "UDP broadcast failed on STA network (attempt %d/%d): %d/%d bytes sent", 
-                   attempt+1, maxRetries, bytesSent, message.length());
+                   attempt+1, maxRetries, bytesSent, length);
           delay(50); // Petit délai avant la prochaine tentative
         }
       } else {
@@ -139,15 +412,15 @@ bool sendBroadcastUDP(const String& action, const String& msg, const String& upd
   if (WiFi.softAPgetStationNum() > 0) {
     for (int attempt = 0; attempt < maxRetries; attempt++) {
       if (udp.beginPacket(apBroadcast, configManager.getControllerPort())) {
-        size_t bytesSent = udp.write((const uint8_t*)message.c_str(), message.length());
-        if (bytesSent == message.length() && udp.endPacket()) {
+        size_t bytesSent = udp.write((const uint8_t*)message, length);
+        if (bytesSent == length && udp.endPacket()) {
           ESP_LOGI(SEND_TAG, "UDP broadcast sent successfully on AP network to %s (%d bytes)", 
                   apBroadcast.toString().c_str(), bytesSent);
           success = true;
           break;
         } else {
           ESP_LOGW(SEND_TAG, "UDP broadcast failed on AP network (attempt %d/%d): %d/%d bytes sent", 
-                   attempt+1, maxRetries, bytesSent, message.length());
+                   attempt+1, maxRetries, bytesSent, length);
           delay(50); // Petit délai avant la prochaine tentative
         }
       } else {
@@ -160,24 +433,163 @@ bool sendBroadcastUDP(const String& action, const String& msg, const String& upd
   return success;
 }
 
+// Tampons partagés des diffusions, détenus ici plutôt que par la WebSocket: chaque client
+// met en file une référence (compteur du tampon), un tampon n'est libéré qu'une fois que plus
+// aucun client ne le référence. Relevés à chaque diffusion, sans parcours interne de la lib.
+#define FRAME_BUFFER_SLOTS 16
+
+AsyncWebSocketMessageBuffer* frameBuffers[FRAME_BUFFER_SLOTS];
+
+// Libère les tampons envoyés; retourne un emplacement libre, -1 si tous sont encore en file
+int8_t reclaimFrameBuffers() {
+    int8_t free = -1;
+    for (int8_t i = 0; i < FRAME_BUFFER_SLOTS; i++) {
+        if (frameBuffers[i] != nullptr && frameBuffers[i]->canDelete()) {
+            delete frameBuffers[i];
+            frameBuffers[i] = nullptr;
+        }
+        if (frameBuffers[i] == nullptr && free < 0) free = i;
+    }
+    return free;
+}
+
+// Clients web de la session courante (session 0 pour un client hors table), parcourus sous
+// webClientsLock. Par référence au tampon partagé, ou par copie s'il ne peut être gardé.
+// Jamais textAll(tampon): son unlock() lève aussi le verrou de l'appelant (drapeau, pas compteur).
+uint8_t textSessionClients(AsyncWebSocketMessageBuffer* shared, bool byReference) {
+    session_t session = currentSession();
+    uint8_t served = 0;
+    lockWebClients();
+    for (AsyncWebSocketClient* client : ws.getClients()) {
+        if (client->status() != WS_CONNECTED || webClientSession(client->id()) != session) continue;
+        if (byReference) client->text(shared);
+        else client->text((const char*)shared->get(), shared->length());
+        served++;
+    }
+    unlockWebClients();
+    return served;
+}
+
+// Encode la trame une fois dans un tampon partagé: les clients de la session et, si demandé,
+// le broadcast UDP lisent les mêmes octets (même TIME_EVENT)
+void broadcastFrame(const String& action, const String& msg, const String& update, bool udp) {
+    FrameHeader header;
+    size_t length = prepareFrame(header, action, msg, update);
+    int8_t slot = reclaimFrameBuffers();
+    AsyncWebSocketMessageBuffer* shared = new AsyncWebSocketMessageBuffer(length);
+    if (shared->get() == nullptr) {
+        delete shared;
+        ESP_LOGE(SEND_TAG, "Unable to allocate %u bytes for %s broadcast", length, action.c_str());
+        return;
+    }
+    const char* message = (const char*)shared->get();
+    writeFrame((char*)shared->get(), header, action, msg, update, length);
+    ESP_LOGD(SEND_TAG, "Broadcasting to Socket%s message: %.*s", udp ? " et UDP" : "", (int)length, message);
+
+    // UDP d'abord, tant que le tampon n'appartient qu'à nous; puis verrou du tampon tenu
+    // pendant la mise en file des clients
+    uint32_t start = micros();
+    if (udp) {
+        sendBroadcastUDP(action, message, length);
+    }
+    shared->lock();
+    if (slot >= 0) frameEncoder.shared++;
+    else frameEncoder.copied++;
+    frameEncoder.fanout += textSessionClients(shared, slot >= 0);
+    shared->unlock();
+    if (slot >= 0) frameBuffers[slot] = shared;
+    else delete shared;
+    radioMicros += micros() - start;
+}
+
+void sendMessageToWebClients(const String& action, const String& msg, const String& update) {
+    broadcastFrame(action, msg, update, false);
+}
+
 void sendMessageToAllClients(const String& action, const String& msg, const String& update) {
-    String message = makeJsonMessage(action, msg, update);
-    ESP_LOGD(SEND_TAG, "Broadcasting to Socket et UDP message: %s", message.c_str());
+    broadcastFrame(action, msg, update, true);
+}
+
+// Diffuse l'état courant (delta ou snapshot) depuis la tâche d'envoi.
+// Le payload est construit sur le dernier snapshot publié: le premier UPDATE d'une rafale
+// porte déjà l'état le plus récent, les suivants sans changement depuis sont absorbés.
+void sendStateUpdate(const String& action, const String& update) {
+    if (update == "" && isStateBroadcastCurrent()) {
+        broadcastStates[currentSession()].coalesced++;
+        ESP_LOGD(SEND_TAG, "State update skipped, version %u already broadcast", broadcastStates[currentSession()].lastVersion);
+        return;
+    }
+    broadcastStates[currentSession()].sent++;
+    String envelope;
+    String payload = getStateUpdateJSON(envelope);
+    if (update != "") {
+        envelope += ", " + update;
+    }
+    sendMessageToAllClients(action, payload, envelope);
+}
 
-    // Envoyer le message en broadcast à tous les clients WebSocket
-    ws.textAll(message.c_str());
-    sendBroadcastUDP(action, msg, update);
+// UPDATE d'état sans champ supplémentaire: interchangeable avec un autre de la même session
+bool isPlainStateUpdate(const OutgoingMessage_t* message) {
+    return message->stateUpdate && !message->notifyAll && message->update.length() == 0;
+}
+
+// Retire de la tête de file les UPDATE d'état qui suivent celui-ci dans la même session:
+// un seul envoi, sur le dernier état publié. Les autres messages (phase, contrôle, ciblés)
+// ne sont jamais retirés ni réordonnés.
+void collapseQueuedStateUpdates(const OutgoingMessage_t* message) {
+    if (!isPlainStateUpdate(message)) return;
+    OutgoingMessage_t* next;
+    while (xQueuePeek(outgoingQueue, &next, 0) == pdTRUE &&
+           isPlainStateUpdate(next) && next->session == message->session) {
+        xQueueReceive(outgoingQueue, &next, 0);
+        ESP_LOGD(SEND_TAG, "State update %i collapsed into %i", next->msgID, message->msgID);
+        broadcastStates[message->session].coalesced++;
+        freeOutgoingMessage(next);
+    }
+}
+
+// Push périodique aux clients web de chaque session (action METRICS, jamais en UDP)
+void pushMetrics() {
+    if (ws.count() == 0) return;
+    String json;
+    {
+        JsonDocument doc(taskJsonAllocator());
+        writeMetrics(doc.to<JsonObject>());
+        serializeJson(doc, json);
+    }
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        SessionScope scope(session);
+        sendMessageToWebClients("METRICS", json, "");
+    }
 }
 
 void sendMessageTask(void *parameter) {
     OutgoingMessage_t* receivedMessage;
+    bindTaskArena(&sendArena);
+    TickType_t nextPush = xTaskGetTickCount() + pdMS_TO_TICKS(METRICS_PUSH_MS);
     while (1) {
         ESP_LOGD(SEND_TAG, "Low stack space in Send Message Task: %i", uxTaskGetStackHighWaterMark(NULL));
         UBaseType_t messagesWaitingBefore = uxQueueMessagesWaiting(outgoingQueue);
         ESP_LOGD(SEND_TAG, "Waiting for incoming messages (%u in queue)", messagesWaitingBefore);
-        
-        if (xQueueReceive(outgoingQueue, &receivedMessage, portMAX_DELAY)) {
+
+        TickType_t wait = portMAX_DELAY;
+        if (METRICS_PUSH_MS > 0) {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(nextPush - now) <= 0) {
+                pushMetrics();
+                sendArena.reset();
+                nextPush = now + pdMS_TO_TICKS(METRICS_PUSH_MS);
+            }
+            wait = nextPush - now;
+        }
+
+        if (xQueueReceive(outgoingQueue, &receivedMessage, wait)) {
+            int64_t dequeued = micros();
+            radioMicros = 0;
+            ActionMetrics* metrics = actionMetrics(sendMetrics, receivedMessage->action.c_str(), receivedMessage->action.length());
+            recordStage(metrics, STAGE_WAIT, dequeued - receivedMessage->enqueuedAt);
             ESP_LOGI(SEND_TAG, "dequeue message %i : %s", receivedMessage->msgID, receivedMessage->action.c_str());
+            SessionScope scope(receivedMessage->session);
             
             switch (hash(receivedMessage->action.c_str())) {
                 case hash("HELLO"):
@@ -197,23 +609,33 @@ void sendMessageTask(void *parameter) {
                     break;
             }
 
-            if (receivedMessage->client != nullptr) {
+            if (receivedMessage->stateUpdate) {
+                collapseQueuedStateUpdates(receivedMessage);
+                sendStateUpdate(receivedMessage->action, receivedMessage->update);
+            } else if (isWebOnlyAction(receivedMessage->action)) {
+                sendMessageToWebClients(receivedMessage->action, receivedMessage->message, receivedMessage->update);
+            } else if (receivedMessage->client != nullptr) {
                 ESP_LOGD(SEND_TAG, "client is not null");
-                sendMessageToClient(receivedMessage->action, *(receivedMessage->message),*(receivedMessage->update), receivedMessage->client);
+                sendMessageToClient(receivedMessage->action, receivedMessage->message,receivedMessage->update, receivedMessage->client);
             } else {
                 ESP_LOGD(SEND_TAG, "client is null");
-                sendMessageToAllClients(receivedMessage->action, *(receivedMessage->message), *(receivedMessage->update));
+                sendMessageToAllClients(receivedMessage->action, receivedMessage->message, receivedMessage->update);
             }
 
             if (receivedMessage->notifyAll) {
                 ESP_LOGD(SEND_TAG, "notify all");
-                notifyAll();
+                sendStateUpdate("UPDATE", "");
             }
+
+            // Traitement = construction et encodage; envoi = remise au réseau
+            uint32_t handled = micros() - dequeued;
+            recordStage(metrics, STAGE_PROCESS, handled - radioMicros);
+            recordStage(metrics, STAGE_SEND, radioMicros);
             
             // Nettoyage
-            delete receivedMessage->message;
-            delete receivedMessage->msgTime;
-            delete receivedMessage;
+            freeOutgoingMessage(receivedMessage);
+            sendArena.reset();
+            sendArena.logUsage();
             ESP_LOGD(SEND_TAG, "queue finished");
         }
     }
@@ -0,0 +1,252 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "gameStore.h"
+#include "scoreLedger.h"
+#include "stateBatch.h"
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+static const char* PERSIST_TAG = "PERSIST";
+
+// Sauvegarde différée: les tâches ne font que publier l'état à sauver et marquer la session
+// sale; la tâche de persistance regroupe les écritures sur une fenêtre (config
+// storage.save_window_ms). Un changement de phase ou de points part sans attendre.
+// Écriture atomique: fichier temporaire puis rename, jamais de sauvegarde tronquée.
+#ifndef SAVE_WINDOW_MS
+#define SAVE_WINDOW_MS 2000
+#endif
+
+struct PersistState {
+    // Dernier état demandé (côté écrivain): une demande identique est ignorée
+    uint32_t requestedVersion;
+    uint32_t requestedCold;
+    uint32_t requestedSeq;
+    uint32_t requestedResets;
+    GamePhase requestedPhase;
+    // À écrire (protégé par persistMux)
+    SnapshotPtr snapshot;
+    uint32_t ledgerSeq;
+    // Journal à compacter une fois ledgerSeq sauvegardé: historique annulable à ce seq
+    bool compact;
+    uint8_t undoCount;
+    uint32_t ledgerResets;
+    LedgerRecord undo[LEDGER_UNDO_DEPTH];
+    bool dirty;
+    bool urgent;
+    uint32_t dirtySince;    // millis() de la première demande non écrite
+    // Compteurs
+    uint32_t requests;
+    uint32_t writes;
+    uint32_t failures;
+    uint32_t lastWriteMs;
+};
+
+PersistState persistStates[MAX_SESSIONS];
+portMUX_TYPE persistMux = portMUX_INITIALIZER_UNLOCKED;
+// Une écriture de sauvegarde à la fois (tâche de persistance, flush avant reboot, annulation)
+SemaphoreHandle_t persistFileMutex = NULL;
+TaskHandle_t persistTaskHandle = NULL;
+uint32_t saveWindowMs = SAVE_WINDOW_MS;
+
+// Demande une sauvegarde de la session courante; appelée après chaque message traité
+void requestSave() {
+    // Lot en cours: une seule demande, à la fin du lot
+    if (activeBatch != nullptr) {
+        activeBatch->save = true;
+        return;
+    }
+    PersistState& p = persistStates[currentSession()];
+    uint32_t version = gameStore().versions.current;
+    uint32_t cold = gameStore().coldRevision;
+    uint32_t seq = scoreLedger().lastSeq;
+    uint32_t resets = scoreLedger().resets;
+    GamePhase phase = getPhase();
+
+    // Rien de neuf depuis la dernière demande (PONG sans effet, FSINFO...)
+    if (version == p.requestedVersion && cold == p.requestedCold && seq == p.requestedSeq &&
+        resets == p.requestedResets && phase == p.requestedPhase) {
+        return;
+    }
+    bool urgent = seq != p.requestedSeq || resets != p.requestedResets || phase != p.requestedPhase;
+    p.requestedVersion = version;
+    p.requestedCold = cold;
+    p.requestedSeq = seq;
+    p.requestedResets = resets;
+    p.requestedPhase = phase;
+
+    publishSnapshot();
+    // Journal trop long: la tâche de persistance le réécrira après cette sauvegarde
+    LedgerRecord undo[LEDGER_UNDO_DEPTH];
+    bool compact = scoreLedger().records > LEDGER_COMPACT_RECORDS;
+    uint8_t undoCount = compact ? copyLedgerUndo(undo) : 0;
+    // Échange sous verrou: l'ancien snapshot est libéré après, hors section critique
+    SnapshotPtr snapshot = pinSnapshot();
+    taskENTER_CRITICAL(&persistMux);
+    p.snapshot.swap(snapshot);
+    p.ledgerSeq = seq;
+    p.compact = compact;
+    p.undoCount = undoCount;
+    p.ledgerResets = resets;
+    memcpy(p.undo, undo, undoCount * sizeof(LedgerRecord));
+    if (!p.dirty) p.dirtySince = millis();
+    p.dirty = true;
+    p.urgent = p.urgent || urgent;
+    p.requests++;
+    taskEXIT_CRITICAL(&persistMux);
+
+    if (persistTaskHandle != NULL) xTaskNotifyGive(persistTaskHandle);
+}
+
+bool writeSaveFile(const StateSnapshot& snapshot, uint32_t ledgerSeq) {
+    JsonDocument doc;
+    writeStore(snapshot, doc);
+    writeLedgerState(snapshot, doc["LEDGER"].to<JsonObject>(), ledgerSeq);
+
+    String saveFile = sessionFile(saveGameFile);
+    String tempFile = saveFile + ".tmp";
+    File file = LittleFS.open(tempFile, "w");
+    if (!file) {
+        ESP_LOGE(PERSIST_TAG, "Failed to open %s for writing", tempFile.c_str());
+        return false;
+    }
+    size_t written = serializeJson(doc, file);
+    file.close();
+    if (written == 0) {
+        ESP_LOGE(PERSIST_TAG, "Failed to write %s", tempFile.c_str());
+        LittleFS.remove(tempFile);
+        return false;
+    }
+    // rename LittleFS remplace la cible de façon atomique
+    if (!LittleFS.rename(tempFile, saveFile)) {
+        ESP_LOGE(PERSIST_TAG, "Unable to rename %s", tempFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Écrit la demande en attente de la session courante, s'il y en a une
+void flushSession() {
+    PersistState& p = persistStates[currentSession()];
+    xSemaphoreTake(persistFileMutex, portMAX_DELAY);
+    SnapshotPtr snapshot;
+    LedgerRecord undo[LEDGER_UNDO_DEPTH];
+    taskENTER_CRITICAL(&persistMux);
+    bool dirty = p.dirty;
+    snapshot.swap(p.snapshot);
+    uint32_t ledgerSeq = p.ledgerSeq;
+    bool compact = p.compact;
+    uint8_t undoCount = p.undoCount;
+    uint32_t ledgerResets = p.ledgerResets;
+    memcpy(undo, p.undo, undoCount * sizeof(LedgerRecord));
+    p.compact = false;
+    p.dirty = false;
+    p.urgent = false;
+    taskEXIT_CRITICAL(&persistMux);
+
+    if (dirty && snapshot) {
+        uint32_t start = millis();
+        if (writeSaveFile(*snapshot, ledgerSeq)) {
+            scoreLedger().savedSeq = ledgerSeq;
+            p.writes++;
+            p.lastWriteMs = millis() - start;
+            ESP_LOGI(PERSIST_TAG, "Session %u saved in %u ms (seq %u)", currentSession(), p.lastWriteMs, ledgerSeq);
+            if (compact) compactScoreLedger(undo, undoCount, ledgerSeq, ledgerResets);
+        } else {
+            // Nouvel essai à la fenêtre suivante, sauf si une demande plus récente est arrivée
+            p.failures++;
+            taskENTER_CRITICAL(&persistMux);
+            if (!p.dirty) {
+                p.snapshot.swap(snapshot);
+                p.ledgerSeq = ledgerSeq;
+                p.compact = compact;
+                p.undoCount = undoCount;
+                p.ledgerResets = ledgerResets;
+                memcpy(p.undo, undo, undoCount * sizeof(LedgerRecord));
+                p.dirty = true;
+                p.dirtySince = millis();
+            }
+            taskEXIT_CRITICAL(&persistMux);
+        }
+    }
+    xSemaphoreGive(persistFileMutex);
+}
+
+// Écrit tout ce qui attend (avant un redémarrage)
+void flushPendingSaves() {
+    if (persistFileMutex == NULL) return;
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        SessionScope scope(session);
+        flushSession();
+    }
+}
+
+// Oublie les demandes en attente (fichiers supprimés ou état rechargé): l'écriture en cours,
+// s'il y en a une, se termine avant
+void cancelPendingSaves() {
+    SnapshotPtr dropped[MAX_SESSIONS];
+    if (persistFileMutex != NULL) xSemaphoreTake(persistFileMutex, portMAX_DELAY);
+    taskENTER_CRITICAL(&persistMux);
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        PersistState& p = persistStates[session];
+        p.dirty = false;
+        p.urgent = false;
+        p.compact = false;
+        dropped[session].swap(p.snapshot);
+        // La prochaine demande part quoi qu'il arrive, sans attendre la fenêtre
+        p.requestedVersion = 0;
+        p.requestedCold = 0;
+        p.requestedPhase = GamePhase::INVALID;
+    }
+    taskEXIT_CRITICAL(&persistMux);
+    if (persistFileMutex != NULL) xSemaphoreGive(persistFileMutex);
+}
+
+void persistTask(void* parameter) {
+    ESP_LOGI(PERSIST_TAG, "Persistence task started, window %u ms", saveWindowMs);
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        for (session_t session = 0; session < MAX_SESSIONS; session++) {
+            PersistState& p = persistStates[session];
+            taskENTER_CRITICAL(&persistMux);
+            bool dirty = p.dirty;
+            bool urgent = p.urgent;
+            uint32_t age = millis() - p.dirtySince;
+            taskEXIT_CRITICAL(&persistMux);
+            if (!dirty) continue;
+
+            if (urgent || age >= saveWindowMs) {
+                SessionScope scope(session);
+                flushSession();
+            } else {
+                TickType_t remaining = pdMS_TO_TICKS(saveWindowMs - age);
+                if (remaining < wait) wait = remaining > 0 ? remaining : 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+void startPersistTask(uint32_t windowMs) {
+    saveWindowMs = windowMs;
+    persistFileMutex = xSemaphoreCreateMutex();
+    ledgerFileMutex = xSemaphoreCreateMutex();
+    xTaskCreate(persistTask, "Persist Task", 8192, NULL, 1, &persistTaskHandle);
+}
+
+void writePersistStats(JsonArray dst) {
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        const PersistState& p = persistStates[session];
+        JsonObject obj = dst.add<JsonObject>();
+        obj["SESSION"] = session;
+        obj["WINDOW_MS"] = saveWindowMs;
+        obj["DIRTY"] = p.dirty;
+        obj["REQUESTS"] = p.requests;
+        obj["WRITES"] = p.writes;
+        obj["FAILURES"] = p.failures;
+        obj["LAST_WRITE_MS"] = p.lastWriteMs;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Common/CustomLogger.h"
+
+#include <ArduinoJson.h>
+
+static const char* METRICS_TAG = "METRICS";
+
+// Mesures du pipeline de messages, par action: attente en file (mise en file -> sortie),
+// traitement, et envoi (file WebSocket + UDP) côté tâche d'envoi. Tables fixes, écrites
+// chacune par une seule tâche; les lectures HTTP tolèrent une valeur en cours de mise à jour.
+#ifndef METRICS_PUSH_MS
+#define METRICS_PUSH_MS 5000    // push "METRICS" aux clients web, 0 = jamais
+#endif
+#define METRICS_MAX_ACTIONS 24
+#define METRICS_ACTION_LEN 16
+#define LATENCY_BUCKETS 13
+
+// Bornes hautes des classes (µs); la dernière classe prend tout le reste
+static const uint32_t latencyBounds[LATENCY_BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000
+};
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint64_t total;
+    uint32_t max;
+};
+
+void recordLatency(LatencyHistogram& h, uint32_t us) {
+    uint8_t bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && us >= latencyBounds[bucket]) bucket++;
+    h.buckets[bucket]++;
+    h.count++;
+    h.total += us;
+    if (us > h.max) h.max = us;
+}
+
+void writeLatency(const LatencyHistogram& h, JsonObject dst) {
+    dst["COUNT"] = h.count;
+    dst["AVG"] = h.count ? (uint32_t)(h.total / h.count) : 0;
+    dst["MAX"] = h.max;
+    JsonArray buckets = dst["H"].to<JsonArray>();
+    for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) buckets.add(h.buckets[i]);
+}
+
+enum PipelineStage : uint8_t { STAGE_WAIT, STAGE_PROCESS, STAGE_SEND, STAGE_COUNT };
+static const char* stageNames[STAGE_COUNT] = { "WAIT", "PROCESS", "SEND" };
+
+struct ActionMetrics {
+    char action[METRICS_ACTION_LEN];    // "" = libre
+    LatencyHistogram stages[STAGE_COUNT];
+};
+
+struct PipelineMetrics {
+    const char* name;
+    ActionMetrics actions[METRICS_MAX_ACTIONS];
+    uint32_t untracked;     // messages au-delà de METRICS_MAX_ACTIONS actions distinctes
+};
+
+PipelineMetrics receiveMetrics = { "RECEIVE" };
+PipelineMetrics sendMetrics = { "SEND" };
+
+// Entrée de l'action (créée au premier message), nullptr si la table est pleine
+ActionMetrics* actionMetrics(PipelineMetrics& metrics, const char* action, size_t length) {
+    if (length == 0) {
+        action = "?";
+        length = 1;
+    }
+    if (length >= METRICS_ACTION_LEN) length = METRICS_ACTION_LEN - 1;
+    for (uint8_t i = 0; i < METRICS_MAX_ACTIONS; i++) {
+        ActionMetrics& entry = metrics.actions[i];
+        if (entry.action[0] == '\0') {
+            memcpy(entry.action, action, length);
+            entry.action[length] = '\0';
+            return &entry;
+        }
+        if (strncmp(entry.action, action, length) == 0 && entry.action[length] == '\0') return &entry;
+    }
+    metrics.untracked++;
+    return nullptr;
+}
+
+void recordStage(ActionMetrics* entry, PipelineStage stage, uint32_t us) {
+    if (entry != nullptr) recordLatency(entry->stages[stage], us);
+}
+
+void writePipelineMetrics(const PipelineMetrics& metrics, JsonObject dst) {
+    JsonObject actions = dst["ACTIONS"].to<JsonObject>();
+    for (uint8_t i = 0; i < METRICS_MAX_ACTIONS; i++) {
+        const ActionMetrics& entry = metrics.actions[i];
+        if (entry.action[0] == '\0') break;
+        JsonObject obj = actions[(const char*)entry.action].to<JsonObject>();
+        for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) {
+            if (entry.stages[stage].count == 0) continue;
+            writeLatency(entry.stages[stage], obj[stageNames[stage]].to<JsonObject>());
+        }
+    }
+    dst["UNTRACKED"] = metrics.untracked;
+}
+
+void writeLatencyBounds(JsonArray dst) {
+    for (uint8_t i = 0; i < LATENCY_BUCKETS - 1; i++) dst.add(latencyBounds[i]);
+}
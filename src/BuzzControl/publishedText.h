@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Texte publié par l'écrivain (ordre des appuis, classement) et relu par les handlers HTTP.
+// Même principe que l'anneau des snapshots: l'écrivain sérialise dans un tampon ni publié
+// ni épinglé, puis le publie; le lecteur épingle le publié le temps de sa copie. Les tampons
+// gardent leur capacité: une fois réservés, une publication n'alloue rien.
+#define PUBLISHED_TEXT_SLOTS 3      // publié, lecteur, écrivain
+
+struct PublishedTextSlot {
+    String text;
+    std::atomic<uint16_t> pins{0};
+};
+
+struct PublishedText {
+    PublishedTextSlot slots[PUBLISHED_TEXT_SLOTS];
+    std::atomic<int8_t> published{-1};
+    String overflow;        // tous les tampons lus: sérialisé ici, non publié
+    uint32_t full;
+};
+
+void reservePublishedText(PublishedText& p, size_t capacity) {
+    for (uint8_t i = 0; i < PUBLISHED_TEXT_SLOTS; i++) p.slots[i].text.reserve(capacity);
+    p.overflow.reserve(capacity);
+}
+
+// Côté écrivain: tampon vidé à remplir, -1 si tous sont lus (le texte va alors dans overflow)
+int8_t claimPublishedText(PublishedText& p) {
+    int8_t current = p.published;
+    for (int8_t i = 0; i < PUBLISHED_TEXT_SLOTS; i++) {
+        if (i != current && p.slots[i].pins == 0) {
+            p.slots[i].text = "";
+            return i;
+        }
+    }
+    p.full++;
+    p.overflow = "";
+    return -1;
+}
+
+String& publishedTextBuffer(PublishedText& p, int8_t index) {
+    return index >= 0 ? p.slots[index].text : p.overflow;
+}
+
+void commitPublishedText(PublishedText& p, int8_t index) {
+    if (index >= 0) p.published = index;
+}
+
+// Côté lecteur: copie du dernier texte publié
+String readPublishedText(PublishedText& p, const char* fallback) {
+    while (true) {
+        int8_t index = p.published;
+        if (index < 0) return String(fallback);
+        PublishedTextSlot& slot = p.slots[index];
+        slot.pins++;
+        if (p.published == index) {
+            String copy = slot.text;
+            slot.pins--;
+            return copy;
+        }
+        slot.pins--;
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "Common/jsonArena.h"
+#include "gameStore.h"
+#include "publishedText.h"
+
+#include <ArduinoJson.h>
+
+static const char* RANKING_TAG = "RANKING";
+
+// Classement des bumpers et des équipes: slots triés par score décroissant, puis par slot
+// (ordre déterministe). Chaque changement de score repositionne l'entité par recherche
+// dichotomique; seules les positions entre l'ancienne et la nouvelle place sont décalées.
+struct RankTable {
+    slot_t  order[MAX_BUMPERS];      // slots triés
+    uint8_t pos[MAX_BUMPERS];        // position de chaque slot dans order, NO_SLOT si absent
+    uint8_t published[MAX_BUMPERS];  // rang lors de la dernière publication, 0 = jamais publié
+    uint8_t count;
+    bool    stale;                   // entités ajoutées/supprimées: reconstruction complète
+};
+
+static_assert(MAX_TEAMS <= MAX_BUMPERS, "RankTable is sized for bumpers");
+
+struct RankingState {
+    RankTable bumpers = { {}, {}, {}, 0, true };
+    RankTable teams = { {}, {}, {}, 0, true };
+    uint32_t revision = 1;            // incrémenté à chaque changement de score ou d'ordre
+    uint32_t publishedRevision = 0;
+    // Dernier classement diffusé, lu sans verrou par /ranking
+    PublishedText published;
+};
+
+// Un classement par session
+RankingState rankingStates[MAX_SESSIONS];
+
+inline RankingState& rankingState() {
+    return rankingStates[currentSession()];
+}
+
+#define RANKING_TEXT_RESERVE 1024
+
+void initRankings() {
+    for (session_t session = 0; session < MAX_SESSIONS; session++) {
+        reservePublishedText(rankingStates[session].published, RANKING_TEXT_RESERVE);
+    }
+}
+
+int32_t rankScore(bool team, slot_t slot) {
+    return team ? gameStore().teamHot[slot].score : gameStore().bumperHot[slot].score;
+}
+
+bool ranksBefore(bool team, slot_t a, slot_t b) {
+    int32_t scoreA = rankScore(team, a);
+    int32_t scoreB = rankScore(team, b);
+    return scoreA > scoreB || (scoreA == scoreB && a < b);
+}
+
+void rebuildRanking(RankTable& table, bool team) {
+    const bool* used = team ? gameStore().teamUsed : gameStore().bumperUsed;
+    slot_t capacity = team ? MAX_TEAMS : MAX_BUMPERS;
+    memset(table.pos, NO_SLOT, sizeof(table.pos));
+    table.count = 0;
+    for (slot_t slot = 0; slot < capacity; slot++) {
+        if (!used[slot]) table.published[slot] = 0;
+    }
+    // Tri par insertion: au plus MAX_BUMPERS entités, uniquement après un changement de structure
+    for (slot_t slot = 0; slot < capacity; slot++) {
+        if (!used[slot]) continue;
+        uint8_t i = table.count++;
+        while (i > 0 && ranksBefore(team, slot, table.order[i - 1])) {
+            table.order[i] = table.order[i - 1];
+            i--;
+        }
+        table.order[i] = slot;
+    }
+    for (uint8_t i = 0; i < table.count; i++) {
+        table.pos[table.order[i]] = i;
+    }
+    table.stale = false;
+}
+
+void repositionRanking(RankTable& table, bool team, slot_t slot) {
+    rankingState().revision++;
+    if (table.stale || slot >= MAX_BUMPERS || table.pos[slot] == NO_SLOT) {
+        table.stale = true;
+        return;
+    }
+    uint8_t from = table.pos[slot];
+    // Retire l'entité puis cherche sa nouvelle place parmi les autres
+    memmove(&table.order[from], &table.order[from + 1], table.count - from - 1);
+    uint8_t others = table.count - 1;
+    uint8_t lo = 0, hi = others;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if (ranksBefore(team, table.order[mid], slot)) lo = mid + 1;
+        else hi = mid;
+    }
+    memmove(&table.order[lo + 1], &table.order[lo], others - lo);
+    table.order[lo] = slot;
+
+    uint8_t first = from < lo ? from : lo;
+    uint8_t last = from < lo ? lo : from;
+    for (uint8_t i = first; i <= last; i++) {
+        table.pos[table.order[i]] = i;
+    }
+}
+
+// Appelés par markBumper/markTeam sur BF_SCORE/TF_SCORE (gameStore.h)
+void rankBumper(slot_t slot) {
+    repositionRanking(rankingState().bumpers, false, slot);
+}
+
+void rankTeam(slot_t slot) {
+    repositionRanking(rankingState().teams, true, slot);
+}
+
+void invalidateRanking() {
+    RankingState& ranking = rankingState();
+    ranking.bumpers.stale = true;
+    ranking.teams.stale = true;
+    ranking.revision++;
+}
+
+bool isRankingChanged() {
+    return rankingState().revision != rankingState().publishedRevision;
+}
+
+// Rangs "compétition": les ex aequo partagent le rang (1, 1, 3). DELTA > 0 = l'entité monte.
+void writeRanking(RankTable& table, bool team, JsonArray dst) {
+    if (table.stale) rebuildRanking(table, team);
+    uint8_t rank = 0;
+    for (uint8_t i = 0; i < table.count; i++) {
+        slot_t slot = table.order[i];
+        if (i == 0 || rankScore(team, slot) != rankScore(team, table.order[i - 1])) rank = i + 1;
+        JsonObject entry = dst.add<JsonObject>();
+        entry["ID"] = team ? (const char*)gameStore().teamCold[slot].id : (const char*)gameStore().bumperCold[slot].id;
+        entry["SCORE"] = rankScore(team, slot);
+        entry["RANK"] = rank;
+        entry["DELTA"] = table.published[slot] ? (int)table.published[slot] - (int)rank : 0;
+        if (!team && gameStore().bumperHot[slot].team != NO_SLOT) {
+            entry["TEAM"] = (const char*)gameStore().teamCold[gameStore().bumperHot[slot].team].id;
+        }
+        table.published[slot] = rank;
+    }
+}
+
+// Construit et publie le classement courant (côté écrivain), valable jusqu'au suivant
+const String& publishRanking() {
+    RankingState& ranking = rankingState();
+    JsonDocument doc(taskJsonAllocator());
+    doc["RANKING_VERSION"] = ranking.revision;
+    writeRanking(ranking.teams, true, doc["teams"].to<JsonArray>());
+    writeRanking(ranking.bumpers, false, doc["bumpers"].to<JsonArray>());
+    ranking.publishedRevision = ranking.revision;
+
+    int8_t index = claimPublishedText(ranking.published);
+    String& output = publishedTextBuffer(ranking.published, index);
+    serializeJson(doc, output);
+    commitPublishedText(ranking.published, index);
+    ESP_LOGD(RANKING_TAG, "Ranking %u published: %s", ranking.publishedRevision, output.c_str());
+    return output;
+}
+
+// /ranking: dernier classement publié (au chargement puis à chaque diffusion)
+String getPublishedRankingJSON() {
+    return readPublishedText(rankingState().published, "{}");
+}
@@ -0,0 +1,337 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "gameStore.h"
+
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static const char* LEDGER_TAG = "SCORE_LEDGER";
+
+// Journal des points: un enregistrement binaire de taille fixe ajouté par attribution.
+// La sauvegarde JSON mémorise le dernier seq qu'elle contient; au démarrage seuls les
+// enregistrements plus récents sont rejoués sur les scores chargés.
+// Un journal par session: "/files/scores.ledger" pour la session 0, "/files/scores.1.ledger"...
+static const char* scoreLedgerPath = "/files/scores.ledger";
+static const char* scoreLedgerTempPath = "/files/scores.ledger.tmp";
+
+#define LEDGER_UNDO_DEPTH      32   // attributions annulables
+#define LEDGER_COMPACT_RECORDS 512  // au-delà, le fichier est réécrit après une sauvegarde
+                                    // (tâche de persistance, persistence.h)
+
+enum LedgerKind : uint8_t { LEDGER_AWARD = 1, LEDGER_UNDO = 2 };
+
+struct __attribute__((packed)) LedgerRecord {
+    uint32_t seq;
+    slot_t   bumper;
+    slot_t   team;          // équipe au moment de l'attribution, NO_SLOT si aucune
+    int16_t  delta;         // points; négatif pour une annulation
+    uint16_t question;      // ID de la question en cours, 0 si aucune
+    uint8_t  kind;          // LedgerKind
+    uint8_t  reserved;
+    int64_t  timestamp;     // micros() du contrôleur
+};
+
+static_assert(sizeof(LedgerRecord) == 20, "LedgerRecord must stay 20 bytes on flash");
+
+// savedSeq est avancé par la tâche de persistance; records et resets ne changent que sous
+// ledgerFileMutex, pris aussi par la compaction. Le reste appartient à l'écrivain.
+struct ScoreLedger {
+    uint32_t lastSeq;                   // dernier seq attribué
+    std::atomic<uint32_t> savedSeq;     // dernier seq intégré dans la sauvegarde JSON
+    std::atomic<uint32_t> records;      // enregistrements présents dans le fichier
+    std::atomic<uint32_t> resets;       // remises à zéro des scores (RAZ, FULL)
+    // Pile circulaire des dernières attributions: undo en O(1)
+    LedgerRecord undo[LEDGER_UNDO_DEPTH];
+    uint8_t undoHead;
+    uint8_t undoCount;
+};
+
+ScoreLedger scoreLedgers[MAX_SESSIONS];
+// Fichier du journal: ajouts et remise à zéro par l'écrivain, compaction par la persistance
+SemaphoreHandle_t ledgerFileMutex = NULL;
+
+inline ScoreLedger& scoreLedger() {
+    return scoreLedgers[currentSession()];
+}
+
+void lockLedgerFile() {
+    if (ledgerFileMutex != NULL) xSemaphoreTake(ledgerFileMutex, portMAX_DELAY);
+}
+
+void unlockLedgerFile() {
+    if (ledgerFileMutex != NULL) xSemaphoreGive(ledgerFileMutex);
+}
+
+void pushLedgerUndo(const LedgerRecord& record) {
+    scoreLedger().undo[scoreLedger().undoHead] = record;
+    scoreLedger().undoHead = (scoreLedger().undoHead + 1) % LEDGER_UNDO_DEPTH;
+    if (scoreLedger().undoCount < LEDGER_UNDO_DEPTH) scoreLedger().undoCount++;
+}
+
+bool popLedgerUndo(LedgerRecord& record) {
+    if (scoreLedger().undoCount == 0) return false;
+    scoreLedger().undoHead = (scoreLedger().undoHead + LEDGER_UNDO_DEPTH - 1) % LEDGER_UNDO_DEPTH;
+    scoreLedger().undoCount--;
+    record = scoreLedger().undo[scoreLedger().undoHead];
+    return true;
+}
+
+// Les totaux en RAM sont les scores du store
+void applyLedgerDelta(const LedgerRecord& record) {
+    if (record.bumper < MAX_BUMPERS && gameStore().bumperUsed[record.bumper]) {
+        gameStore().bumperHot[record.bumper].score += record.delta;
+        markBumper(record.bumper, BF_SCORE);
+    }
+    if (record.team < MAX_TEAMS && gameStore().teamUsed[record.team]) {
+        gameStore().teamHot[record.team].score += record.delta;
+        markTeam(record.team, TF_SCORE);
+    }
+}
+
+bool writeLedgerRecords(const LedgerRecord* records, uint8_t count) {
+    if (count == 0) return true;
+    String scoreLedgerFile = sessionFile(scoreLedgerPath);
+    size_t expected = count * sizeof(LedgerRecord);
+    lockLedgerFile();
+    File file = LittleFS.open(scoreLedgerFile, "a");
+    if (!file) {
+        unlockLedgerFile();
+        ESP_LOGE(LEDGER_TAG, "Failed to open %s for append", scoreLedgerFile.c_str());
+        return false;
+    }
+    size_t written = file.write((const uint8_t*)records, expected);
+    file.close();
+    // Enregistrement incomplet ignoré au rejeu: seuls les complets comptent
+    scoreLedger().records += written / sizeof(LedgerRecord);
+    unlockLedgerFile();
+    if (written != expected) {
+        ESP_LOGE(LEDGER_TAG, "Short write on %s (%u/%u bytes)", scoreLedgerFile.c_str(), (unsigned)written, (unsigned)expected);
+        return false;
+    }
+    return true;
+}
+
+// Lot d'actions (ACTIONS): les enregistrements sont retenus par l'écrivain, puis ajoutés au
+// fichier en une écriture à la fin du lot (ou quand le tampon est plein)
+#define LEDGER_BATCH_RECORDS 64
+
+struct LedgerBatch {
+    LedgerRecord records[LEDGER_BATCH_RECORDS];
+    uint8_t count;
+    bool open;
+};
+
+LedgerBatch ledgerBatch;
+
+void beginLedgerBatch() {
+    ledgerBatch.count = 0;
+    ledgerBatch.open = true;
+}
+
+bool flushLedgerBatch() {
+    bool written = writeLedgerRecords(ledgerBatch.records, ledgerBatch.count);
+    ledgerBatch.count = 0;
+    return written;
+}
+
+bool commitLedgerBatch() {
+    ledgerBatch.open = false;
+    return flushLedgerBatch();
+}
+
+bool appendLedgerRecord(const LedgerRecord& record) {
+    if (!ledgerBatch.open) return writeLedgerRecords(&record, 1);
+    ledgerBatch.records[ledgerBatch.count++] = record;
+    return ledgerBatch.count < LEDGER_BATCH_RECORDS || flushLedgerBatch();
+}
+
+// Attribue des points au bumper (et à son équipe actuelle); retourne l'enregistrement ajouté
+LedgerRecord awardScore(slot_t bumper, int points, uint16_t question, int64_t timestamp) {
+    LedgerRecord record = {};
+    record.seq = ++scoreLedger().lastSeq;
+    record.bumper = bumper;
+    record.team = (bumper < MAX_BUMPERS) ? gameStore().bumperHot[bumper].team : NO_SLOT;
+    record.delta = (int16_t)constrain(points, INT16_MIN, INT16_MAX);
+    record.question = question;
+    record.kind = LEDGER_AWARD;
+    record.timestamp = timestamp;
+
+    applyLedgerDelta(record);
+    appendLedgerRecord(record);
+    pushLedgerUndo(record);
+    ESP_LOGD(LEDGER_TAG, "Award #%u: bumper %u team %u %+d (question %u)", record.seq, record.bumper, record.team, record.delta, record.question);
+    return record;
+}
+
+// Annule les "count" dernières attributions par des enregistrements compensatoires
+int undoScores(int count, int64_t timestamp) {
+    int undone = 0;
+    LedgerRecord award;
+    while (undone < count && popLedgerUndo(award)) {
+        LedgerRecord record = award;
+        record.seq = ++scoreLedger().lastSeq;
+        record.delta = -award.delta;
+        record.kind = LEDGER_UNDO;
+        record.timestamp = timestamp;
+        applyLedgerDelta(record);
+        appendLedgerRecord(record);
+        ESP_LOGI(LEDGER_TAG, "Undo award #%u (%+d) as #%u", award.seq, award.delta, record.seq);
+        undone++;
+    }
+    return undone;
+}
+
+// Scores remis à zéro (RAZ, FULL): l'historique ne s'applique plus. Le seq reste monotone.
+void resetScoreLedger() {
+    String scoreLedgerFile = sessionFile(scoreLedgerPath);
+    // RAZ dans un lot: les attributions retenues avant elle ne s'appliquent plus
+    ledgerBatch.count = 0;
+    lockLedgerFile();
+    if (LittleFS.exists(scoreLedgerFile) && !LittleFS.remove(scoreLedgerFile)) {
+        ESP_LOGE(LEDGER_TAG, "Unable to delete %s", scoreLedgerFile.c_str());
+    }
+    scoreLedger().records = 0;
+    scoreLedger().resets++;
+    unlockLedgerFile();
+    scoreLedger().undoHead = 0;
+    scoreLedger().undoCount = 0;
+    ESP_LOGI(LEDGER_TAG, "Ledger reset at seq %u", scoreLedger().lastSeq);
+}
+
+/* **** PERSISTANCE *** */
+
+// Bloc "LEDGER" de la sauvegarde: seq couvert et slots des entités, pour relire les
+// enregistrements même si les slots changent au rechargement
+void writeLedgerState(const StateSnapshot& s, JsonObject dst, uint32_t seq) {
+    dst["SEQ"] = seq;
+    JsonArray bumpers = dst["bumpers"].to<JsonArray>();
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+        bumpers.add(s.tables.bumperUsed[slot] ? (const char*)s.tables.bumperCold[slot].id : "");
+    }
+    JsonArray teams = dst["teams"].to<JsonArray>();
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+        teams.add(s.tables.teamUsed[slot] ? (const char*)s.tables.teamCold[slot].id : "");
+    }
+}
+
+slot_t mapLedgerSlot(JsonArrayConst roster, slot_t slot, bool bumper) {
+    if (slot == NO_SLOT) return NO_SLOT;
+    // Pas de table (ancienne sauvegarde): slots pris tels quels
+    if (roster.isNull()) return slot;
+    const char* id = roster[slot] | "";
+    if (id[0] == '\0') return NO_SLOT;
+    return bumper ? findBumperSlot(id) : findTeamSlot(id);
+}
+
+// Rejoue le journal sur les scores chargés (après loadStore)
+void replayScoreLedger(JsonObjectConst saved) {
+    String scoreLedgerFile = sessionFile(scoreLedgerPath);
+    scoreLedger().savedSeq = saved["SEQ"] | 0;
+    scoreLedger().lastSeq = scoreLedger().savedSeq;
+    scoreLedger().records = 0;
+    scoreLedger().undoHead = 0;
+    scoreLedger().undoCount = 0;
+
+    // Compactage interrompu: le temporaire n'a pas été renommé
+    String scoreLedgerTempFile = sessionFile(scoreLedgerTempPath);
+    if (LittleFS.exists(scoreLedgerTempFile)) {
+        if (LittleFS.exists(scoreLedgerFile)) {
+            // Journal intact, temporaire peut-être incomplet
+            LittleFS.remove(scoreLedgerTempFile);
+            ESP_LOGW(LEDGER_TAG, "Leftover %s removed", scoreLedgerTempFile.c_str());
+        } else if (LittleFS.rename(scoreLedgerTempFile, scoreLedgerFile)) {
+            ESP_LOGW(LEDGER_TAG, "Ledger recovered from %s", scoreLedgerTempFile.c_str());
+        }
+    }
+
+    File file = LittleFS.open(scoreLedgerFile, "r");
+    if (!file) {
+        ESP_LOGI(LEDGER_TAG, "No ledger, scores from save file (seq %u)", scoreLedger().savedSeq.load());
+        return;
+    }
+    JsonArrayConst bumpers = saved["bumpers"].as<JsonArrayConst>();
+    JsonArrayConst teams = saved["teams"].as<JsonArrayConst>();
+    uint32_t replayed = 0;
+    LedgerRecord record;
+    while (file.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+        scoreLedger().records++;
+        record.bumper = mapLedgerSlot(bumpers, record.bumper, true);
+        record.team = mapLedgerSlot(teams, record.team, false);
+        if (record.kind == LEDGER_AWARD) {
+            pushLedgerUndo(record);
+        } else {
+            LedgerRecord award;
+            popLedgerUndo(award);
+        }
+        if (record.seq > scoreLedger().savedSeq) {
+            applyLedgerDelta(record);
+            replayed++;
+        }
+        if (record.seq > scoreLedger().lastSeq) scoreLedger().lastSeq = record.seq;
+    }
+    // Enregistrement incomplet (coupure pendant l'écriture): ignoré
+    if (file.available() > 0) {
+        ESP_LOGW(LEDGER_TAG, "Ignoring %u trailing bytes in %s", (unsigned)file.available(), scoreLedgerFile.c_str());
+    }
+    file.close();
+    ESP_LOGI(LEDGER_TAG, "Ledger loaded: %u records, %u replayed, seq %u", scoreLedger().records.load(), replayed, scoreLedger().lastSeq);
+}
+
+// Historique annulable (du plus ancien au plus récent), copié par l'écrivain pour la compaction
+uint8_t copyLedgerUndo(LedgerRecord* dst) {
+    uint8_t first = (scoreLedger().undoHead + LEDGER_UNDO_DEPTH - scoreLedger().undoCount) % LEDGER_UNDO_DEPTH;
+    for (uint8_t i = 0; i < scoreLedger().undoCount; i++) {
+        dst[i] = scoreLedger().undo[(first + i) % LEDGER_UNDO_DEPTH];
+    }
+    return scoreLedger().undoCount;
+}
+
+// Tâche de persistance, une fois "seq" couvert par une sauvegarde: seul l'historique
+// annulable à ce seq reste utile, suivi des enregistrements ajoutés depuis par l'écrivain
+void compactScoreLedger(const LedgerRecord* undo, uint8_t undoCount, uint32_t seq, uint32_t resets) {
+    String scoreLedgerFile = sessionFile(scoreLedgerPath);
+    String scoreLedgerTempFile = sessionFile(scoreLedgerTempPath);
+
+    lockLedgerFile();
+    // Journal remis à zéro depuis la demande: l'historique copié ne vaut plus
+    if (scoreLedger().resets != resets || scoreLedger().records <= LEDGER_COMPACT_RECORDS) {
+        unlockLedgerFile();
+        return;
+    }
+    File source = LittleFS.open(scoreLedgerFile, "r");
+    File file = LittleFS.open(scoreLedgerTempFile, "w");
+    if (!source || !file) {
+        if (source) source.close();
+        if (file) file.close();
+        unlockLedgerFile();
+        ESP_LOGE(LEDGER_TAG, "Failed to open %s for compaction", scoreLedgerTempFile.c_str());
+        return;
+    }
+    for (uint8_t i = 0; i < undoCount; i++) {
+        file.write((const uint8_t*)&undo[i], sizeof(LedgerRecord));
+    }
+    uint32_t kept = undoCount;
+    LedgerRecord record;
+    while (source.read((uint8_t*)&record, sizeof(record)) == sizeof(record)) {
+        if (record.seq > seq) {
+            file.write((const uint8_t*)&record, sizeof(record));
+            kept++;
+        }
+    }
+    source.close();
+    file.close();
+    // rename LittleFS atomique et remplace la cible: journal ancien ou compacté, jamais aucun
+    bool renamed = LittleFS.rename(scoreLedgerTempFile, scoreLedgerFile);
+    uint32_t records = scoreLedger().records;
+    if (renamed) scoreLedger().records = kept;
+    unlockLedgerFile();
+
+    if (!renamed) {
+        ESP_LOGE(LEDGER_TAG, "Unable to rename %s", scoreLedgerTempFile.c_str());
+        return;
+    }
+    ESP_LOGI(LEDGER_TAG, "Ledger compacted: %u -> %u records", records, kept);
+}
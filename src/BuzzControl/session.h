@@ -0,0 +1,151 @@
+#pragma once
+#include "Common/CustomLogger.h"
+
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+static const char* SESSION_TAG = "SESSION";
+
+// Sessions de jeu indépendantes servies par un même contrôleur (une salle par session):
+// store, phase, timer, classement, journal des points et diffusions sont propres à chacune.
+#ifndef MAX_SESSIONS
+#define MAX_SESSIONS 2
+#endif
+#define NO_SESSION 0xFF
+
+typedef uint8_t session_t;
+
+// Session de la tâche courante: les tables par session sont lues à cet index.
+// Posée par SessionScope à l'entrée de chaque message, requête HTTP ou tick de timer.
+thread_local session_t currentSessionId = 0;
+
+inline session_t currentSession() {
+    return currentSessionId;
+}
+
+// Travaille dans une session le temps d'une portée, puis revient à la précédente
+class SessionScope {
+public:
+    explicit SessionScope(session_t session) : previous_(currentSessionId) {
+        currentSessionId = session < MAX_SESSIONS ? session : 0;
+    }
+    ~SessionScope() { currentSessionId = previous_; }
+private:
+    session_t previous_;
+};
+
+// NO_SESSION si hors limites
+session_t validSession(long session) {
+    if (session < 0 || session >= MAX_SESSIONS) {
+        ESP_LOGW(SESSION_TAG, "Invalid session %ld", session);
+        return NO_SESSION;
+    }
+    return (session_t)session;
+}
+
+// "SESSION": 1 ou "1"; NO_SESSION si absent
+session_t parseSession(JsonVariantConst value) {
+    if (value.isNull()) return NO_SESSION;
+    return validSession(value.is<const char*>() ? atol(value.as<const char*>()) : value.as<long>());
+}
+
+// Fichier de la session courante: "/files/game.json.save" -> "/files/game.1.json.save".
+// La session 0 garde les noms historiques.
+String sessionFile(const char* path) {
+    session_t session = currentSession();
+    if (session == 0) return String(path);
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    const char* ext = strchr(name, '.');
+    if (ext == nullptr) return String(path) + "." + String(session);
+    return String(path).substring(0, ext - path) + "." + String(session) + ext;
+}
+
+//#### CLIENTS WEB ###
+// Session de chaque client WebSocket, choisie au HELLO (session 0 par défaut).
+// Écrit par le handler WebSocket et la tâche de réception, lu par la tâche d'envoi.
+#define MAX_WEB_CLIENTS 16
+
+struct WebClientEntry {
+    uint32_t id;            // AsyncWebSocketClient::id(), 0 = libre
+    session_t session;
+};
+
+WebClientEntry webClients[MAX_WEB_CLIENTS];
+portMUX_TYPE webClientsMux = portMUX_INITIALIZER_UNLOCKED;
+// Liste des clients de la WebSocket: tenu par le handler aux connexions et déconnexions
+// (le client n'est libéré qu'après son WS_EVT_DISCONNECT) et par la tâche d'envoi pendant
+// qu'elle parcourt getClients()
+SemaphoreHandle_t webClientsLock = NULL;
+
+void lockWebClients() {
+    if (webClientsLock != NULL) xSemaphoreTake(webClientsLock, portMAX_DELAY);
+}
+
+void unlockWebClients() {
+    if (webClientsLock != NULL) xSemaphoreGive(webClientsLock);
+}
+
+void registerWebClient(uint32_t id) {
+    taskENTER_CRITICAL(&webClientsMux);
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (webClients[i].id == 0) {
+            webClients[i].id = id;
+            webClients[i].session = 0;
+            taskEXIT_CRITICAL(&webClientsMux);
+            return;
+        }
+    }
+    taskEXIT_CRITICAL(&webClientsMux);
+    ESP_LOGW(SESSION_TAG, "Web client table full, client %u not tracked", id);
+}
+
+void unregisterWebClient(uint32_t id) {
+    taskENTER_CRITICAL(&webClientsMux);
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (webClients[i].id == id) webClients[i].id = 0;
+    }
+    taskEXIT_CRITICAL(&webClientsMux);
+}
+
+void setWebClientSession(uint32_t id, session_t session) {
+    taskENTER_CRITICAL(&webClientsMux);
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (webClients[i].id == id) webClients[i].session = session;
+    }
+    taskEXIT_CRITICAL(&webClientsMux);
+    ESP_LOGI(SESSION_TAG, "Web client %u joined session %u", id, session);
+}
+
+session_t webClientSession(uint32_t id) {
+    session_t session = 0;
+    taskENTER_CRITICAL(&webClientsMux);
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (webClients[i].id == id) session = webClients[i].session;
+    }
+    taskEXIT_CRITICAL(&webClientsMux);
+    return session;
+}
+
+// Clients de la session; retourne true si aucun client suivi n'est dans une autre session
+// (diffusion à tous possible, y compris aux clients absents de la table)
+bool collectWebClients(session_t session, uint32_t* ids, uint8_t& count) {
+    bool alone = true;
+    count = 0;
+    taskENTER_CRITICAL(&webClientsMux);
+    for (uint8_t i = 0; i < MAX_WEB_CLIENTS; i++) {
+        if (webClients[i].id == 0) continue;
+        if (webClients[i].session == session) ids[count++] = webClients[i].id;
+        else alone = false;
+    }
+    taskEXIT_CRITICAL(&webClientsMux);
+    return alone;
+}
+
+uint8_t countWebClients(session_t session) {
+    uint32_t ids[MAX_WEB_CLIENTS];
+    uint8_t count;
+    collectWebClients(session, ids, count);
+    return count;
+}
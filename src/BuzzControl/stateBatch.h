@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// Lot d'actions web (ACTIONS) appliqué d'un bloc par la tâche de réception: tant qu'il est
+// ouvert, les UPDATE d'état et les sauvegardes demandés par cette tâche sont retenus, puis
+// émis une seule fois sur l'état final. Les autres tâches ne sont pas concernées.
+struct StateBatch {
+    uint16_t updates = 0;   // UPDATE d'état retenus
+    bool notify = false;
+    bool save = false;      // sauvegarde demandée
+    // Événements joints à l'UPDATE du lot: aucun n'est perdu
+    String points;          // objets POINTS, séparés par des virgules: diffusés en tableau
+    int undone = 0;         // attributions annulées par les UNDO du lot, cumulées
+    uint32_t undoSeq = 0;   // seq du journal après le dernier UNDO
+    bool buzzOrder = false; // BUZZ_ORDER retenu (BUZZ_NEXT), diffusé après l'UPDATE
+};
+
+thread_local StateBatch* activeBatch = nullptr;
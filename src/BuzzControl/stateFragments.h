@@ -0,0 +1,133 @@
+#pragma once
+#include "Common/CustomLogger.h"
+#include "Common/jsonArena.h"
+#include "gameStore.h"
+
+#include <ArduinoJson.h>
+
+static const char* FRAGMENT_TAG = "FRAGMENTS";
+
+// Fragments JSON pré-encodés de l'état: "id":{...} par bumper et par équipe, plus l'objet
+// GAME. Un fragment n'est ré-encodé que si la version d'un de ses champs a bougé depuis
+// son encodage (dirty); un état complet se réduit alors à une concaténation.
+struct Fragment {
+    uint32_t stamp;     // version de l'entité à l'encodage, 0 = jamais encodé
+    String json;
+};
+
+// Un cache par tâche consommatrice (écrivain, envoi) et par session: aucun verrou
+struct FragmentCache {
+    Fragment bumpers[MAX_BUMPERS];
+    Fragment teams[MAX_TEAMS];
+    Fragment game;
+    uint32_t encoded;   // fragments ré-encodés
+    uint32_t reused;    // fragments repris tels quels
+};
+
+FragmentCache writerFragments[MAX_SESSIONS];
+FragmentCache sendFragments[MAX_SESSIONS];
+
+size_t fragmentBytes(const FragmentCache& cache) {
+    size_t bytes = cache.game.json.length();
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) bytes += cache.bumpers[slot].json.length();
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) bytes += cache.teams[slot].json.length();
+    return bytes;
+}
+
+// Version d'une entité: la plus récente de ses champs. Une suppression (structure) ou une
+// nouvelle manche touche aussi les références et les champs de manche: elles comptent.
+uint32_t fragmentStamp(const uint32_t* fields, uint8_t count, const StateVersions& v, bool roundScoped) {
+    uint32_t stamp = v.structure;
+    if (roundScoped && v.round > stamp) stamp = v.round;
+    for (uint8_t i = 0; i < count; i++) {
+        if (fields[i] > stamp) stamp = fields[i];
+    }
+    return stamp + 1;   // jamais 0
+}
+
+// Encode {"id":{...}} puis retire les accolades externes
+void encodeEntry(Fragment& fragment, JsonDocument& doc) {
+    fragment.json = "";
+    serializeJson(doc, fragment.json);
+    fragment.json.remove(fragment.json.length() - 1);
+    fragment.json.remove(0, 1);
+}
+
+const String& bumperFragment(FragmentCache& cache, const StateSnapshot& s, slot_t slot) {
+    Fragment& fragment = cache.bumpers[slot];
+    uint32_t stamp = fragmentStamp(s.tables.versions.bumper[slot], BF_COUNT, s.tables.versions, true);
+    if (fragment.stamp == stamp) {
+        cache.reused++;
+        return fragment.json;
+    }
+    JsonDocument doc(taskJsonAllocator());
+    writeBumperFields(s, slot, doc[(const char*)s.tables.bumperCold[slot].id].to<JsonObject>());
+    encodeEntry(fragment, doc);
+    fragment.stamp = stamp;
+    cache.encoded++;
+    return fragment.json;
+}
+
+const String& teamFragment(FragmentCache& cache, const StateSnapshot& s, slot_t slot) {
+    Fragment& fragment = cache.teams[slot];
+    uint32_t stamp = fragmentStamp(s.tables.versions.team[slot], TF_COUNT, s.tables.versions, true);
+    if (fragment.stamp == stamp) {
+        cache.reused++;
+        return fragment.json;
+    }
+    JsonDocument doc(taskJsonAllocator());
+    writeTeamFields(s, slot, doc[(const char*)s.tables.teamCold[slot].id].to<JsonObject>());
+    encodeEntry(fragment, doc);
+    fragment.stamp = stamp;
+    cache.encoded++;
+    return fragment.json;
+}
+
+// "GAME":{...}
+const String& gameFragment(FragmentCache& cache, const StateSnapshot& s) {
+    Fragment& fragment = cache.game;
+    uint32_t stamp = fragmentStamp(s.tables.versions.game, GF_COUNT, s.tables.versions, false);
+    if (fragment.stamp == stamp) {
+        cache.reused++;
+        return fragment.json;
+    }
+    JsonDocument doc(taskJsonAllocator());
+    writeGameFields(s, doc["GAME"].to<JsonObject>());
+    encodeEntry(fragment, doc);
+    fragment.stamp = stamp;
+    cache.encoded++;
+    return fragment.json;
+}
+
+// Même contenu que writeStore + serializeJson, assemblé depuis les fragments
+String assembleState(FragmentCache& cache, const StateSnapshot& s) {
+    String output = "{\"bumpers\":{";
+    bool first = true;
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+        if (!s.tables.bumperUsed[slot]) continue;
+        if (!first) output += ',';
+        output += bumperFragment(cache, s, slot);
+        first = false;
+    }
+    output += "},\"teams\":{";
+    first = true;
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+        if (!s.tables.teamUsed[slot]) continue;
+        if (!first) output += ',';
+        output += teamFragment(cache, s, slot);
+        first = false;
+    }
+    output += "},";
+    output += gameFragment(cache, s);
+    output += '}';
+    ESP_LOGD(FRAGMENT_TAG, "State assembled (%u bytes), %u encoded / %u reused so far", output.length(), cache.encoded, cache.reused);
+    return output;
+}
+
+// {"GAME":{...}}
+String assembleGame(FragmentCache& cache, const StateSnapshot& s) {
+    String output = "{";
+    output += gameFragment(cache, s);
+    output += '}';
+    return output;
+}
@@ -24,26 +24,11 @@ void startBumperServer() {
 }
 
 void b_handleData(void* arg, AsyncClient* c, void *data, size_t len) {
-    String clientID = c->remoteIP().toString();
-    String partial_data = String((char*)data, len);
-    ESP_LOGD(TCP_TAG, "Received data from %s: %s", clientID.c_str(), partial_data.c_str());
+    conn_t conn = (conn_t)(uintptr_t)arg;
+    ESP_LOGD(TCP_TAG, "Received data from connection %u: %.*s", conn, (int)len, (const char*)data);
 
-    clientBuffers[clientID] += partial_data;
-    processClientBuffer(clientID, c);
-}
-
-void processClientBuffer(const String& clientID, AsyncClient* c) {
-    String& jsonBuffer = clientBuffers[clientID];
-    int endOfJson;
-    ESP_LOGD(TCP_TAG, "processClientBuffer %s", jsonBuffer.c_str());
-
-    while ((endOfJson = jsonBuffer.indexOf('\0')) > 0) {
-        String jsonPart = jsonBuffer.substring(0, endOfJson);
-        jsonBuffer = jsonBuffer.substring(endOfJson + 1);
-        
-        // Au lieu de traiter directement, envoyez à la file d'attente des messages entrants
-        enqueueIncomingMessage("TCP", jsonPart.c_str(), c);
-    }
+    // Trames copiées une fois dans l'anneau d'entrée
+    enqueueFrames(MessageSource::TCP, conn, 0, (const uint8_t*)data, len);
 }
 
 static void listClients() {
@@ -62,6 +47,7 @@ static void removeClientsByIP(const IPAddress& ip) {
         if(existingClient->remoteIP() == ip) {
             ESP_LOGI(TCP_TAG, "Removing old connection from IP: %s", ip.toString().c_str());
             existingClient->close(true);
+            enqueueIncomingMessage(MessageSource::TCP_CLOSE, "", 0, closeConnection(existingClient), 0);
             delete existingClient;
             it = bumperClients.erase(it);
         } else {
@@ -76,7 +62,14 @@ static void b_onCLientConnect(void* arg, AsyncClient* client) {
     // Supprimer les anciennes connexions de cette IP
     removeClientsByIP(client->remoteIP());
 
-    client->onData(&b_handleData, NULL);
+    conn_t conn = openConnection(client);
+    if (conn == NO_CONN) {
+        ESP_LOGE(TCP_TAG, "Connection table full, refusing %s", client->remoteIP().toString().c_str());
+        client->close(true);
+        delete client;
+        return;
+    }
+    client->onData(&b_handleData, (void*)(uintptr_t)conn);
     bumperClients.push_back(client);
     size_t nbClients = bumperClients.size();
     ESP_LOGD(TCP_TAG, "Nb clients : %i", nbClients);
@@ -90,6 +83,7 @@ static void b_onClientDisconnect(void* arg, AsyncClient* client) {
     // Rechercher et supprimer le client de la liste
     for (auto it = bumperClients.begin(); it != bumperClients.end(); ++it) {
         if (*it == client) {
+            enqueueIncomingMessage(MessageSource::TCP_CLOSE, "", 0, closeConnection(client), 0);
             bumperClients.erase(it);
             break;
         }
@@ -1,40 +1,25 @@
 #pragma once
 #include "Common/CustomLogger.h"
 #include "Common/led.h"
+#include "Common/jsonArena.h"
+
+#include "gameStore.h"
+#include "scoreLedger.h"
+#include "ranking.h"
+#include "buzzOrder.h"
+#include "stateFragments.h"
+#include "persistence.h"
 
 #include <ArduinoJson.h>
 
 static const char* TEAMs_TAG = "Team And Bumper";
 static const char* QUESTION_TAG = "Questions";
 
-JsonDocument teamsAndBumpers;
-JsonDocument& getTeamsAndBumpers() {
-    return teamsAndBumpers;
-}
-
-JsonObject getKEYObj(String key) {
-  JsonDocument& doc=getTeamsAndBumpers();
-  if (doc[key].isNull()) {
-    doc[key] = JsonObject();
-  }
-  return doc[key].as<JsonObject>();
-}
-
-JsonObject getTeamsObj() {
-  return getKEYObj("teams");
-}
-
-JsonObject getBumpersObj() {
-  return getKEYObj("bumpers");
-}
-
-JsonObject getGameObj() {
-  return getKEYObj("GAME");
-}
-
-String getTeamsAndBumpersJSON() {
+// Sérialise un snapshot figé: aucune lecture de l'état vivant
+String serializeSnapshot(const StateSnapshot& snapshot) {
   String output;
-  JsonDocument& tb=getTeamsAndBumpers();
+  JsonDocument tb(taskJsonAllocator());
+  writeStore(snapshot, tb);
   if (serializeJson(tb, output)) {
     ESP_LOGI(TEAMs_TAG, "TeamsAndGame: %s", output.c_str());
     return output;
@@ -44,161 +29,100 @@ String getTeamsAndBumpersJSON() {
   }
 }
 
+// Côté écrivain: publie l'état courant puis l'assemble depuis les fragments en cache
+String getTeamsAndBumpersJSON() {
+  publishSnapshot();
+  return assembleState(writerFragments[currentSession()], *pinSnapshot());
+}
+
+// Côté lecteur (HTTP): dernier état publié, sans toucher aux tables vivantes
+String getPublishedStateJSON() {
+  return serializeSnapshot(*pinSnapshot());
+}
+
 // ### GAME ### */
-void setBackgroundFile(String pathBackground) {
-    String path;
-  if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-  // Copy the GAME object to our temporary document
-  
-  if (!teamsAndBumpers["GAME"]["background"].isNull()) {
-    path=teamsAndBumpers["GAME"]["background"].as<String>();
+void setBackgroundFile(const char* pathBackground) {
+  JsonObject game = gameColdObj();
+  if (!game["background"].isNull()) {
+    String path = game["background"].as<String>();
     deleteFile(path.c_str());
   }
 
-  teamsAndBumpers["GAME"]["background"]=pathBackground;
+  game["background"] = pathBackground;
+  markGame(GF_COLD);
 }
 
+// UPDATE_TIMER chaque seconde: seul le fragment GAME est ré-encodé, et seulement s'il a changé
 String getGameJSON() {
-  String output;
-  JsonDocument doc;
-  
-  // Copy the GAME object to our temporary document
-  doc["GAME"] = getGameObj();
-  
-  if (serializeJson(doc, output)) {
-    return output;
-  } else {
-    ESP_LOGE(TEAMs_TAG, "Failed to serialize JSON");
-    return "{}";
-  }
+  publishSnapshot();
+  return assembleGame(writerFragments[currentSession()], *pinSnapshot());
 }
 
-void setGamePhase(String phase) {
-    getGameObj()["PHASE"] = phase;
+// Seule voie pour changer de phase: validation par la table, version, puis hooks
+bool fireGamePhase(PhaseEvent event) {
+    GamePhase from, to;
+    if (!tryPhaseEvent(event, from, to)) {
+        return false;
+    }
+    markGame(GF_PHASE);
+    runPhaseHooks(from, to, event);
+    // Changement de phase: sauvegardé sans attendre la fenêtre, y compris depuis le timer
+    requestSave();
+    return true;
 }
 
-String getGamePhase() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    return teamsAndBumpers["GAME"]["PHASE"];
+const char* getGamePhase() {
+    return gamePhaseName(getPhase());
 }
 
 bool isGameStarted() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"]=="START") {
-        return true;
-    }
-    return false;
+    return getPhase() == GamePhase::START;
 }
 
 bool isGameStopped() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"]=="STOP") {
-        return true;
-    }
-    return false;
+    return getPhase() == GamePhase::STOP;
 }
 
 bool isGamePrepare() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"]=="PREPARE") {
-        return true;
-    }
-    return false;
+    return getPhase() == GamePhase::PREPARE;
 }
 
 bool isGameReady() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"]=="READY") {
-        return true;
-    }
-    return false;
+    return getPhase() == GamePhase::READY;
 }
 
 bool isGamePaused() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"].isNull()) {
-        teamsAndBumpers["GAME"]["PHASE"] = "";
-    }
-    if (teamsAndBumpers["GAME"]["PHASE"]=="PAUSE") {
-        return true;
-    }
-    return false;
+    return getPhase() == GamePhase::PAUSE;
 }
 
 void setGameTime() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-        teamsAndBumpers["GAME"]["TIME"] = micros();
+    gameStore().game.time = micros();
+    markGame(GF_TIME);
 }
 
 void setGameCurrentTime(const int currentTime) {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    teamsAndBumpers["GAME"]["CURRENT_TIME"] = currentTime;
-
+    gameStore().game.currentTime = currentTime;
+    markGame(GF_CURRENT_TIME);
 }
 
 int getGameCurrentTime() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["CURRENT_TIME"].isNull()) {
-        teamsAndBumpers["GAME"]["CURRENT_TIME"] = 0;
-    }
-    return teamsAndBumpers["GAME"]["CURRENT_TIME"];
-
+    return gameStore().game.currentTime;
 }
 
 void setGameDelay(int delay=33) {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    teamsAndBumpers["GAME"]["DELAY"] = delay;
+    gameStore().game.delay = delay;
+    markGame(GF_DELAY);
 }
 
-void setGamePage(const String remotePage) {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-        teamsAndBumpers["GAME"]["REMOTE"] = remotePage;
+void setGamePage(const char* remotePage) {
+    gameColdObj()["REMOTE"] = remotePage;
+    markGame(GF_COLD);
 }
 //##### QUESTION ######
 int findFreeQuestion() {
     try {
         if (!LittleFS.begin(true)) {
             ESP_LOGE(QUESTION_TAG, "Failed to mount LittleFS");
-            xSemaphoreGive(questionMutex);
             return 0;
         }
 
@@ -285,36 +209,42 @@ String getQuestions() {
     return jsonOutput;
 }
 
-void setCurrentQuestion(const String qID) {
+void setCurrentQuestion(const char* qID) {
     String question="";
     String qPath=questionsPath+"/"+qID+"/question.json";
 
     question=readFile(qPath);
 
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    
     ESP_LOGD(QUESTION_TAG, "Set Question %s: %s", qID, question.c_str());
     
-    DeserializationError error = deserializeJson(teamsAndBumpers["GAME"]["QUESTION"], question);
+    JsonObject game = gameColdObj();
+    DeserializationError error = deserializeJson(game["QUESTION"], question);
     if (error) {
         ESP_LOGE(QUESTION_TAG, "deserializeJson() failed: %s", error.c_str());
-        teamsAndBumpers["GAME"].remove("QUESTION");
-    } 
+        game.remove("QUESTION");
+        // Une clé supprimée ne peut pas être exprimée en delta
+        markStructure();
+    } else {
+        markGame(GF_COLD);
+    }
 }
 
 JsonObject getCurrentQuestion() {
-    if (teamsAndBumpers["GAME"].isNull()) {
-        teamsAndBumpers["GAME"] = JsonObject();
-    }
-    if (teamsAndBumpers["GAME"]["QUESTION"].isNull()) {
-        teamsAndBumpers["GAME"]["QUESTION"] = JsonObject();
+    JsonObject game = gameColdObj();
+    if (game["QUESTION"].isNull()) {
+        return game["QUESTION"].to<JsonObject>();
     }
-    return teamsAndBumpers["GAME"]["QUESTION"];
+    return game["QUESTION"];
 }
 
-String getQuestionElement(String Element) {
+// ID numérique de la question en cours, 0 si aucune (journal des points)
+uint16_t getCurrentQuestionID() {
+    JsonVariantConst id = gameColdObj()["QUESTION"]["ID"];
+    if (id.is<const char*>()) return (uint16_t)atoi(id.as<const char*>());
+    return id | 0;
+}
+
+String getQuestionElement(const char* Element) {
     return getCurrentQuestion()[Element];
 }
 
@@ -330,7 +260,7 @@ String getQuestionElementJson() {
         return "";
     }
 }
-void writeQuestion(String id, String question) {
+void writeQuestion(const char* id, const String& question) {
 
     ensureDirectoryExists(questionsPath);
     String fullPath = questionsPath + "/" + id;
@@ -347,13 +277,16 @@ void writeQuestion(String id, String question) {
     }
 }
 
-void setQuestionStatus(String status) {
+void setQuestionStatus(const char* status) {
     JsonObject tb=getCurrentQuestion();
     String output;
     tb["STATUS"]=status;
+    markGame(GF_COLD);
     if (serializeJson(tb, output)) {
         ESP_LOGI(QUESTION_TAG, "Question: %s", output.c_str());
-        writeQuestion(tb["ID"],output);
+        char idBuffer[12];
+        const char* id = idArg(tb["ID"], idBuffer, sizeof(idBuffer));
+        if (id[0] != '\0') writeQuestion(id, output);
     } else {
         ESP_LOGE(QUESTION_TAG, "Failed to serialize JSON");
     }
@@ -375,36 +308,10 @@ String getQuestionResponse() {
     return getQuestionElement("ANSWER");
 }
 
-//### BUMPERS ###
-JsonObject getBumpers() {
-    return teamsAndBumpers["bumpers"].as<JsonObject>();
-}
-
-void setBumpers(const JsonObject& bumpers) {
-  teamsAndBumpers["bumpers"] = bumpers;
-}
-
-JsonObject getBumper(const char* bumperID) {
-    return teamsAndBumpers["bumpers"][String(bumperID)].as<JsonObject>();
-}
-
-void setBumper(const char* bumperID, const JsonObject& bumper){
-  teamsAndBumpers["bumpers"][String(bumperID)] = bumper;
-}
 
-String  ensureBumperExists(const char* bumperID) {
-    if (bumperID == nullptr || strlen(bumperID) == 0) {
-        ESP_LOGE(TEAMs_TAG, "Invalid bumperID provided: %s", bumperID);
-    }
-    String bID = String(bumperID);
-    if (teamsAndBumpers["bumpers"].isNull()) {
-        teamsAndBumpers["bumpers"] = JsonObject();
-    }
-
-    if (teamsAndBumpers["bumpers"][bID].isNull()) {
-        teamsAndBumpers["bumpers"][bID]=JsonObject();
-    }
-    return bID;
+//### BUMPERS ###
+void setBumpers(JsonObjectConst bumpers) {
+  loadBumpers(bumpers);
 }
 
 void setBumperIP(const char* bumperID, const char* IP) {
@@ -414,10 +321,9 @@ void setBumperIP(const char* bumperID, const char* IP) {
 
     ESP_LOGD("Teams&Bumpers","set IP: %s => %s", bumperID, IP);
 
-    String bID = ensureBumperExists(bumperID);
-
-    String ipCopy = String(IP);
-    teamsAndBumpers["bumpers"][bID]["IP"] = ipCopy;
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    setBumperIPSlot(slot, IP);
 }
 
 void setBumperNAME(const char* bumperID, const char* NAME) {
@@ -426,11 +332,11 @@ void setBumperNAME(const char* bumperID, const char* NAME) {
     }
     ESP_LOGD(TEAMs_TAG,"set NAME: %s:%s", bumperID, NAME);
 
-    String bID = ensureBumperExists(bumperID);
-
-    String NAMECopy = String(NAME);
-    teamsAndBumpers["bumpers"][bID]["NAME"] = NAMECopy;
-    ESP_LOGI(TEAMs_TAG, "Bumper NAME %s => %s", bID.c_str(), NAMECopy.c_str());
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    bumperColdObj(slot)["NAME"] = NAME;
+    markBumper(slot, BF_COLD);
+    ESP_LOGI(TEAMs_TAG, "Bumper NAME %s => %s", bumperID, NAME);
 }
 
 void setBumperVERSION(const char* bumperID, const char* version) {
@@ -440,282 +346,348 @@ void setBumperVERSION(const char* bumperID, const char* version) {
 
     ESP_LOGD("Teams&Bumpers","set VERSION: %s => %s", bumperID, version);
 
-    String bID = ensureBumperExists(bumperID);
-
-    String ipCopy = String(version);
-    teamsAndBumpers["bumpers"][bID]["VERSION"] = ipCopy;
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    bumperColdObj(slot)["VERSION"] = version;
+    markBumper(slot, BF_COLD);
 }
 
-void setBumperButton(const char* bumperID, String button) {
-    String bID = ensureBumperExists(bumperID);
-
-    String copy = String (button);
-    teamsAndBumpers["bumpers"][bID]["BUTTON"] = copy;
-    ESP_LOGI(TEAMs_TAG, "Bumper Button %s %s", bID.c_str(), copy.c_str());
+void setBumperButton(const char* bumperID, const char* button) {
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    copyFixed(bumperRound(slot).button, sizeof(gameStore().bumperHot[slot].button), button);
+    markBumper(slot, BF_BUTTON);
+    ESP_LOGI(TEAMs_TAG, "Bumper Button %s %s", bumperID, button);
 }
 
-void setBumperStatus(const char* bumperID, String status) {
-    String bID = ensureBumperExists(bumperID);
-
-    String copy = String(status);
-    teamsAndBumpers["bumpers"][bID]["STATUS"] = copy;
-    ESP_LOGI(TEAMs_TAG, "Bumper Status %s %s", bID.c_str(), copy.c_str());
+void setBumperStatus(const char* bumperID, const char* status) {
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    bumperRound(slot).status = parseEntityStatus(status);
+    markBumper(slot, BF_STATUS);
+    ESP_LOGI(TEAMs_TAG, "Bumper Status %s %s", bumperID, status);
 }
 
 void setBumperScore(const char* bumperID, const int new_score) {
-    String bID = ensureBumperExists(bumperID);
-
-    int copy = int(new_score);
-    teamsAndBumpers["bumpers"][bID]["SCORE"]=copy;
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    gameStore().bumperHot[slot].score = new_score;
+    markBumper(slot, BF_SCORE);
 }
 
 int  updateBumperScore(const char* bumperID, const int points) {
-    String bID = ensureBumperExists(bumperID);
-    int score=teamsAndBumpers["bumpers"][bID]["SCORE"];
-    int newscore=score+points;
-    ESP_LOGI(TEAMs_TAG, "Bumper update old Score %s %i+%i=%i", bID.c_str(), score, points, newscore);
-    teamsAndBumpers["bumpers"][bID]["SCORE"]=newscore;
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return 0;
+    int score = gameStore().bumperHot[slot].score;
+    int newscore = score + points;
+    ESP_LOGI(TEAMs_TAG, "Bumper update old Score %s %i+%i=%i", bumperID, score, points, newscore);
+    gameStore().bumperHot[slot].score = newscore;
+    markBumper(slot, BF_SCORE);
     return newscore;
 }
 
-const String getBumperTeam(const char* bumperID) {
-    String bID = ensureBumperExists(bumperID);
-    String tId=teamsAndBumpers["bumpers"][bID]["TEAM"];
-    return tId;
+// Retourne l'ID d'équipe du bumper, nullptr s'il n'est affecté à aucune équipe
+const char* getBumperTeam(const char* bumperID) {
+    slot_t slot = findBumperSlot(bumperID);
+    if (slot == NO_SLOT || gameStore().bumperHot[slot].team == NO_SLOT) return nullptr;
+    return teamIdOf(gameStore().bumperHot[slot].team);
 }
 
 const int64_t getBumperTime(const char* bumperID) {
-    String bID = ensureBumperExists(bumperID);
-    return int64_t(teamsAndBumpers["bumpers"][bID]["TIMESTAMP"]);
+    slot_t slot = findBumperSlot(bumperID);
+    if (slot == NO_SLOT) return 0;
+    const BumperHot& hot = gameStore().bumperHot[slot];
+    return hot.epoch == gameStore().roundEpoch ? hot.timestamp : 0;
 }
 
 void setBumperTime(const char* bumperID, const int64_t new_delay) {
-    String bID = ensureBumperExists(bumperID);
-
-    int64_t copy = int64_t(new_delay);
-    teamsAndBumpers["bumpers"][bID]["TIMESTAMP"]=copy;
-    ESP_LOGI(TEAMs_TAG, "BumperID Delay %s %lld", bID.c_str(), copy);
+    slot_t slot = allocBumperSlot(bumperID);
+    if (slot == NO_SLOT) return;
+    bumperRound(slot).timestamp = new_delay;
+    markBumper(slot, BF_TIMESTAMP);
+    ESP_LOGI(TEAMs_TAG, "BumperID Delay %s %lld", bumperID, new_delay);
 }
 
 void resetBumpersReady() {
-  JsonObject bumpers = getBumpers();
-  if (!bumpers.isNull()) {
-    for (JsonPair bumperPair : bumpers) {
-      JsonObject bumper = bumperPair.value().as<JsonObject>();
-      bumper["READY"]="FALSE";
+  for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+    if (gameStore().bumperUsed[slot]) {
+      gameStore().bumperHot[slot].ready = ReadyState::NOT_READY;
+      markBumper(slot, BF_READY);
     }
-  } else {
-    ESP_LOGW(TEAMs_TAG, "Bumpers object is null or invalid");
-  }  
+  }
+  gameStore().readiness.stale = true;
   ESP_LOGI(TEAMs_TAG, "All bumpers marked as not ready");
 }
 
-void setBumperReady(const char* bumperID) {
-  String bID = ensureBumperExists(bumperID);
-  teamsAndBumpers["bumpers"][bID]["READY"]="TRUE";
-  ESP_LOGI(TEAMs_TAG, "Bumper %s marked as ready", bID.c_str());
+void setTeamReadyState(slot_t slot, ReadyState ready) {
+  if (gameStore().teamHot[slot].ready != ready) {
+    gameStore().teamHot[slot].ready = ready;
+    markTeam(slot, TF_READY);
+  }
 }
 
-void  mergeJson(JsonObject& destObj, const JsonObject& srcObj) {
-  for (JsonPair kvp : srcObj) {
-      ESP_LOGD("Teams&Bumpers","Merging: %s", kvp.key());
-
-      destObj[kvp.key()] = kvp.value();
+// Recalcul complet des compteurs et du READY des équipes (PREPARE, changement d'équipes)
+void updateTeamsReady() {
+  ReadinessCounters& r = gameStore().readiness;
+  memset(r.expected, 0, sizeof(r.expected));
+  memset(r.pending, 0, sizeof(r.pending));
+  r.teamsNotReady = 0;
+
+  for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) {
+    const BumperHot& bumper = gameStore().bumperHot[slot];
+    if (!gameStore().bumperUsed[slot] || bumper.team == NO_SLOT || bumper.ready == ReadyState::UNSET) continue;
+    r.expected[bumper.team]++;
+    if (bumper.ready == ReadyState::NOT_READY) r.pending[bumper.team]++;
+  }
+  for (slot_t slot = 0; slot < MAX_TEAMS; slot++) {
+    if (!gameStore().teamUsed[slot]) continue;
+    if (r.pending[slot] > 0) {
+      r.teamsNotReady++;
+      setTeamReadyState(slot, ReadyState::NOT_READY);
+    } else {
+      setTeamReadyState(slot, ReadyState::READY);
     }
+  }
+  r.stale = false;
+  ESP_LOGD(TEAMs_TAG, "Team readiness recomputed: %u teams not ready", r.teamsNotReady);
+}
+
+// PONG: met à jour les compteurs de l'équipe du bumper en O(1).
+// Retourne false si le bumper était déjà prêt (rien à diffuser).
+bool setBumperReadySlot(slot_t slot) {
+  BumperHot& bumper = gameStore().bumperHot[slot];
+  if (bumper.ready == ReadyState::READY) return false;
+
+  ReadinessCounters& r = gameStore().readiness;
+  if (r.stale) updateTeamsReady();
+  bool counted = bumper.ready == ReadyState::NOT_READY && bumper.team != NO_SLOT;
+  bumper.ready = ReadyState::READY;
+  markBumper(slot, BF_READY);
+  if (bumper.team != NO_SLOT) {
+    if (!counted) {
+      // Bumper qui n'était pas attendu (READY absent): il rejoint simplement son équipe
+      r.expected[bumper.team]++;
+    } else if (r.pending[bumper.team] > 0 && --r.pending[bumper.team] == 0) {
+      r.teamsNotReady--;
+      setTeamReadyState(bumper.team, ReadyState::READY);
+      ESP_LOGI(TEAMs_TAG, "Team %s ready (%u bumpers)", teamIdOf(bumper.team), r.expected[bumper.team]);
+    }
+  }
+  ESP_LOGI(TEAMs_TAG, "Bumper %s marked as ready, %u teams not ready", bumperIdOf(slot), r.teamsNotReady);
+  return true;
 }
 
-void updateBumper(const char* bumperID, const JsonObject& new_bumper) {
-    String output;
-    serializeJson(new_bumper, output);
-  ESP_LOGD("Teams&Bumpers","Updating: bumper %s : %s", bumperID, output.c_str());
-  JsonObject bumper = getBumper(bumperID);
-  if (bumper.isNull()) {
-    setBumper(bumperID,new_bumper);
+void setBumperReady(const char* bumperID) {
+  slot_t slot = allocBumperSlot(bumperID);
+  if (slot == NO_SLOT) return;
+  setBumperReadySlot(slot);
+}
 
+void updateBumper(const char* bumperID, JsonObjectConst new_bumper) {
+  ESP_LOGD("Teams&Bumpers","Updating: bumper %s", bumperID);
+  slot_t slot = findBumperSlot(bumperID);
+  if (slot == NO_SLOT) {
+    slot = allocBumperSlot(bumperID);
+    if (slot != NO_SLOT) {
+      loadBumperFields(slot, new_bumper);
+    }
   } else {
       if (!new_bumper["IP"].isNull()) { setBumperIP(bumperID, new_bumper["IP"]); };
       if (!new_bumper["NAME"].isNull()) { setBumperNAME(bumperID, new_bumper["NAME"]); };
       if (!new_bumper["VERSION"].isNull()) { setBumperVERSION(bumperID, new_bumper["VERSION"]); };
   }
-  bumper = getBumper(bumperID);
-  serializeJson(bumper, output);
-  ESP_LOGD("Teams&Bumpers","Updating: merged bumper %s : %s", bumperID, output.c_str());
-  
 }
 
-void updateBumpers(const JsonObject& bumpers) {
-    String output;
-    serializeJson(bumpers, output);
-  ESP_LOGD("Teams&Bumpers","Updating: bumpers %s", output.c_str());
-  for (JsonPair obj : bumpers) {
-        updateBumper(obj.key().c_str(), obj.value().as<JsonObject>());
+void updateBumpers(JsonObjectConst bumpers) {
+  for (JsonPairConst obj : bumpers) {
+        updateBumper(obj.key().c_str(), obj.value().as<JsonObjectConst>());
       }
 }
 
 String getBumperIDByIP(const char* clientIP) {
-  JsonObject bumpers = getBumpers();
-  for (JsonPair bumperPair : bumpers) {
-    JsonObject bumper = bumperPair.value().as<JsonObject>();
-    if (bumper["IP"].as<String>() == clientIP) {
-      return String(bumperPair.key().c_str());
-    }
+  slot_t slot = findBumperSlotByIP(clientIP);
+  if (slot == NO_SLOT) {
+    return String(); // Retourne une chaîne vide si aucune correspondance n'est trouvée
   }
-  return String(); // Retourne une chaîne vide si aucune correspondance n'est trouvée
+  return String(bumperIdOf(slot));
 }
 
 //#### TEAMS ###
-JsonObject getTeams() {
-    return teamsAndBumpers["teams"].as<JsonObject>();
-}
-
-JsonObject getTeam(const char* teamID) {
-    return teamsAndBumpers["teams"][teamID].as<JsonObject>();
-}
-
-void setTeams(const JsonObject& teams) {
-  teamsAndBumpers["teams"] = teams;
+void setTeams(JsonObjectConst teams) {
+  loadTeams(teams);
 }
 
-void setTeam(const char* teamID, const JsonObject& team){
-  teamsAndBumpers["teams"][teamID] = team;
+// Remplace équipes et bumpers en une fois (FULL): les équipes d'abord pour résoudre TEAM
+void setTeamsAndBumpers(JsonObjectConst root) {
+  loadTeamsAndBumpers(root);
+  // Scores et slots remplacés: l'historique du journal ne s'applique plus
+  resetScoreLedger();
 }
 
-String  ensureTeamExists(const char* teamID) {
-    if (teamID == nullptr || strlen(teamID) == 0) {
-        ESP_LOGE(TEAMs_TAG, "Invalid teamID provided: %s", teamID);
-    }
-    if (teamsAndBumpers["teams"].isNull()) {
-        teamsAndBumpers["teams"] = JsonObject();
-    }
-    String bID = String(teamID);
-    if (teamsAndBumpers["teams"][bID].isNull()) {
-        teamsAndBumpers["teams"][bID]=JsonObject();
-    }
-    return bID;
-}
-
-void setTeamStatus(const char* teamID, String status) {
-    String bID = ensureTeamExists(teamID);
-    String copy = String(status);
-    teamsAndBumpers["teams"][bID]["STATUS"] = copy;
-    ESP_LOGI(TEAMs_TAG, "Team Status %s %s", bID, copy);
+void setTeamStatus(const char* teamID, const char* status) {
+    slot_t slot = allocTeamSlot(teamID);
+    if (slot == NO_SLOT) return;
+    teamRound(slot).status = parseEntityStatus(status);
+    markTeam(slot, TF_STATUS);
+    ESP_LOGI(TEAMs_TAG, "Team Status %s %s", teamID, status);
 }
 
 const int64_t getTeamTime(const char* teamID) {
-    return int64_t(teamsAndBumpers["teams"][teamID]["TIMESTAMP"]);
+    slot_t slot = findTeamSlot(teamID);
+    if (slot == NO_SLOT) return 0;
+    const TeamHot& hot = gameStore().teamHot[slot];
+    return hot.epoch == gameStore().roundEpoch ? hot.timestamp : 0;
 }
 
 void setTeamTime(const char* teamID, const int64_t new_delay) {
-    String bID = ensureTeamExists(teamID);
-    int64_t copy = int64_t(new_delay);
-    teamsAndBumpers["teams"][bID]["TIMESTAMP"]=copy;
-    ESP_LOGI(TEAMs_TAG, "Team Delay %s %i", bID, copy);
+    slot_t slot = allocTeamSlot(teamID);
+    if (slot == NO_SLOT) return;
+    teamRound(slot).timestamp = new_delay;
+    markTeam(slot, TF_TIMESTAMP);
+    ESP_LOGI(TEAMs_TAG, "Team Delay %s %lld", teamID, new_delay);
 }
 
 void setTeamBumper(const char* teamID, const char* bumperID) {
-    String bID = ensureTeamExists(teamID);
-    String copy = String(bumperID);
-    teamsAndBumpers["teams"][bID]["BUMPER"] = copy;
-    ESP_LOGI(TEAMs_TAG, "Team Bumper %s %s", teamID, copy.c_str());
+    slot_t slot = allocTeamSlot(teamID);
+    if (slot == NO_SLOT) return;
+    teamRound(slot).bumper = findBumperSlot(bumperID);
+    markTeam(slot, TF_BUMPER);
+    ESP_LOGI(TEAMs_TAG, "Team Bumper %s %s", teamID, bumperID);
 }
 
 void setTeamScore(const char* teamID, const int new_score) {
-    String bID = ensureTeamExists(teamID);
-    int copy = int(new_score);
-    teamsAndBumpers["teams"][bID]["SCORE"] = copy;
-    ESP_LOGI(TEAMs_TAG, "Team Score %s %i", bID, copy);
+    slot_t slot = allocTeamSlot(teamID);
+    if (slot == NO_SLOT) return;
+    gameStore().teamHot[slot].score = new_score;
+    markTeam(slot, TF_SCORE);
+    ESP_LOGI(TEAMs_TAG, "Team Score %s %i", teamID, new_score);
 }
 
+int  updateBumperTeamScore(const char* bumperID, const int points) {
+    ESP_LOGI(TEAMs_TAG, "team Bumper update old Score %s %i", bumperID, points);
 
+    slot_t slot = findBumperSlot(bumperID);
+    if (slot == NO_SLOT || gameStore().bumperHot[slot].team == NO_SLOT) {
+        ESP_LOGW(TEAMs_TAG, "Bumper %s has no team, team score unchanged", bumperID);
+        return 0;
+    }
+    slot_t teamSlot = gameStore().bumperHot[slot].team;
+    TeamHot& team = gameStore().teamHot[teamSlot];
+    int score = team.score;
+    int newscore = score + points;
+    ESP_LOGI(TEAMs_TAG, "Bumper Team update old Score %s %s %i+%i=%i", bumperID, teamIdOf(gameStore().bumperHot[slot].team), score, points, newscore);
 
-
-
-
-/*
-void updateBumperScore(const char* bumperID, const int points) {
-    String bID = ensureBumperExists(bumperID);
-    int score=teamsAndBumpers["bumpers"][bID]["SCORE"];
-    int newscore=score+points;
-    ESP_LOGI(TEAMs_TAG, "Bumper update old Score %s %i+%i=%i", bID.c_str(), score, points, newscore);
-    teamsAndBumpers["bumpers"][bID]["SCORE"]=newscore;
+    team.score = newscore;
+    markTeam(teamSlot, TF_SCORE);
+    return newscore;
 }
 
-*/
-
+void updateTeam(const char* teamID, JsonObjectConst new_team) {
+  slot_t slot = allocTeamSlot(teamID);
+  if (slot == NO_SLOT) return;
+  loadTeamFields(slot, new_team);
+}
 
+void updateTeams(JsonObjectConst teams) {
+  for (JsonPairConst obj : teams) {
+        updateTeam(obj.key().c_str(), obj.value().as<JsonObjectConst>());
+      }
+}
 
+bool areAllTeamsReady() {
+    if (gameStore().readiness.stale) updateTeamsReady();
+    return gameStore().readiness.teamsNotReady == 0;
+}
 
+// Remise à zéro des champs de manche (BUTTON, TIMESTAMP, STATUS, BUMPER): O(1), voir startNewRound
+void resetRoundFields() {
+  startNewRound();
+}
 
-int  updateBumperTeamScore(const char* bumperID, const int points) {
-    ESP_LOGI(TEAMs_TAG, "team Bumper update old Score %s %i", bumperID, points);
+//#### STATE BROADCAST ###
+struct BroadcastState {
+  uint32_t lastVersion = 0;                  // version déjà diffusée; avancée par la tâche d'envoi seule
+  // Snapshots complets demandés (écrivain) et servis (tâche d'envoi): une demande arrivée
+  // pendant la construction d'un UPDATE reste en attente pour le suivant
+  std::atomic<uint32_t> fullRequested{1};
+  uint32_t fullServed = 0;
+  uint32_t sent = 0;                         // UPDATE d'état diffusés
+  uint32_t coalesced = 0;                    // UPDATE absorbés par une diffusion plus récente
+};
 
-    String bID=(teamsAndBumpers["bumpers"][String(bumperID)]["TEAM"]);
-    int score=teamsAndBumpers["teams"][bID]["SCORE"];
-    int newscore=score+points;
-    ESP_LOGI(TEAMs_TAG, "Bumper Team update old Score %s %s %i+%i=%i",bumperID, bID.c_str(), score, points, newscore);
+BroadcastState broadcastStates[MAX_SESSIONS];
 
-    teamsAndBumpers["teams"][bID]["SCORE"] = int(teamsAndBumpers["teams"][bID]["SCORE"])+points;
-    return newscore;
+// Le prochain UPDATE d'état de la session sera un snapshot complet (nouveau client, trou de version signalé)
+void requestFullSnapshot() {
+  broadcastStates[currentSession()].fullRequested++;
 }
 
-void updateTeam(const char* teamID, const JsonObject& new_team) {
-  JsonObject team = getTeam(teamID);
-  mergeJson(team, new_team);
-  setTeam(teamID, team);
+// Aucune version plus récente que la dernière diffusion, et pas de snapshot complet demandé:
+// l'UPDATE n'aurait rien à dire (tâche d'envoi)
+bool isStateBroadcastCurrent() {
+  const BroadcastState& broadcast = broadcastStates[currentSession()];
+  return broadcast.fullRequested == broadcast.fullServed && pinSnapshot()->tables.versions.current == broadcast.lastVersion;
 }
 
-void updateTeams(const JsonObject& teams) {
-  for (JsonPair obj : teams) {
-        updateTeam(obj.key().c_str(), obj.value().as<JsonObject>());
-      }
-}
+// Payload d'un UPDATE d'état (tâche d'envoi): delta depuis la dernière diffusion, ou snapshot complet,
+// calculé sur le dernier snapshot publié.
+// envelope reçoit STATE_VERSION (et BASE_VERSION/DELTA pour un delta), placés hors de MSG.
+String getStateUpdateJSON(String& envelope) {
+  String output;
+  JsonDocument doc(taskJsonAllocator());
+  doc.to<JsonObject>();
+  SnapshotPtr snapshot = pinSnapshot();
+  BroadcastState& broadcast = broadcastStates[currentSession()];
+  uint32_t version = snapshot->tables.versions.current;
+  uint32_t base = broadcast.lastVersion;
+
+  uint32_t requested = broadcast.fullRequested;
+  bool isDelta = requested == broadcast.fullServed && writeStoreDelta(*snapshot, doc, base);
+  broadcast.fullServed = requested;
+  broadcast.lastVersion = version;
+
+  envelope = "\"STATE_VERSION\": " + String(version);
+  if (!isDelta) {
+    // Snapshot complet: concaténation des fragments, seuls ceux modifiés sont ré-encodés
+    output = assembleState(sendFragments[currentSession()], *snapshot);
+    ESP_LOGD(TEAMs_TAG, "State snapshot %u: %s", version, output.c_str());
+    return output;
+  }
+  envelope += ", \"BASE_VERSION\": " + String(base) + ", \"DELTA\": true";
 
-void resetTeamsReady() {
-JsonObject teams = getTeams();
-  if (!teams.isNull()) {
-    for (JsonPair teamPair : teams) {
-      JsonObject team = teamPair.value().as<JsonObject>();
-      team["READY"]="true";
-    }
-    ESP_LOGI(TEAMs_TAG, "All teams marked as initially ready");
+  if (serializeJson(doc, output)) {
+    ESP_LOGD(TEAMs_TAG, "State delta %u->%u: %s", base, version, output.c_str());
+    return output;
   } else {
-    ESP_LOGW(TEAMs_TAG, "Teams object is null or invalid");
+    ESP_LOGE(TEAMs_TAG, "Failed to serialize JSON");
+    return "{}";
   }
 }
 
-void updateTeamsReady() {
-JsonObject team;
-    resetTeamsReady() ;
-    ESP_LOGD(TEAMs_TAG, "Updating team readiness status");
-
-    JsonObject bumpers = getBumpers();
-    if (!bumpers.isNull()) {
-        for (JsonPair bumperPair : bumpers) {
-            JsonObject bumper = bumperPair.value().as<JsonObject>();
-            const char* teamID = bumper["TEAM"];
-            if (teamID != nullptr && bumper["READY"] == "FALSE") {
-                JsonObject  team=getTeam(bumper["TEAM"]);
-                if (!team.isNull()) {
-                    team["READY"]="FALSE";
-                    ESP_LOGD(TEAMs_TAG, "Team %s marked as not ready due to bumper status", teamID);
-                }
-            }
-        }
-    } else {
-        ESP_LOGW(TEAMs_TAG, "Bumpers object is null or invalid when updating team readiness");
-    }
-}
-
-bool areAllTeamsReady() {
-    JsonObject teams = getTeams();
-    if (!teams.isNull()) {
-        for (JsonPair teamPair : teams) {
-            JsonObject team = teamPair.value().as<JsonObject>();
-            if (team["READY"] == "FALSE") {
-                return false;
-            }
-        }
-        return true;
-    }
-    return false;
+//#### SESSIONS ###
+// /memory: empreinte de chaque session
+void writeSessionStats(JsonArray dst) {
+  for (session_t session = 0; session < MAX_SESSIONS; session++) {
+    SessionScope scope(session);
+    const GameStore& store = gameStore();
+    uint8_t bumpers = 0, teams = 0;
+    for (slot_t slot = 0; slot < MAX_BUMPERS; slot++) bumpers += store.bumperUsed[slot];
+    for (slot_t slot = 0; slot < MAX_TEAMS; slot++) teams += store.teamUsed[slot];
+
+    JsonObject entry = dst.add<JsonObject>();
+    entry["SESSION"] = session;
+    entry["PHASE"] = getGamePhase();
+    entry["BUMPERS"] = bumpers;
+    entry["TEAMS"] = teams;
+    entry["WEB_CLIENTS"] = countWebClients(session);
+    entry["STATIC"] = sizeof(GameStore) + sizeof(RankingState) + sizeof(BuzzOrder) + sizeof(ScoreLedger)
+                    + 2 * sizeof(FragmentCache) + sizeof(BroadcastState) + sizeof(PoolStats)
+                    + sizeof(SnapshotRing);
+    entry["COLD_POOL"] = store.coldAllocator.used();
+    entry["COLD_POOL_PEAK"] = store.coldAllocator.peak();
+    entry["FRAGMENTS"] = fragmentBytes(writerFragments[session]) + fragmentBytes(sendFragments[session]);
+    entry["UPDATES_SENT"] = broadcastStates[session].sent;
+    entry["UPDATES_COALESCED"] = broadcastStates[session].coalesced;
+    writeSnapshotStats(entry["SNAPSHOTS"].to<JsonObject>());
+  }
 }
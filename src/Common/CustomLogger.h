@@ -5,6 +5,7 @@
 #include <WiFiUdp.h>
 #include <esp_log.h>
 #include <time.h>
+#include <atomic>
 
 static const char* LOGGER_TAG = "LOGGER";
 
@@ -46,6 +47,35 @@ private:
         strftime(buffer, bufferSize, "%Y-%m-%d %H:%M:%S", &timeinfo);
     }
 
+    // Tampons de ligne réservés une fois: pas d'allocation par log tant que deux tâches
+    // au plus écrivent en même temps (au-delà, repli sur le tas)
+    enum { BUFFER_SIZE = 2048, LINE_BUFFERS = 2 };
+    static char lineBuffers[LINE_BUFFERS][BUFFER_SIZE];
+    static std::atomic<uint8_t> lineBusy;
+
+    static char* claimLineBuffer() {
+        for (uint8_t i = 0; i < LINE_BUFFERS; i++) {
+            uint8_t bit = 1 << i;
+            if (!(lineBusy.fetch_or(bit) & bit)) return lineBuffers[i];
+        }
+        return (char*)malloc(BUFFER_SIZE);
+    }
+
+    static void releaseLineBuffer(char* buffer) {
+        for (uint8_t i = 0; i < LINE_BUFFERS; i++) {
+            if (buffer == lineBuffers[i]) {
+                lineBusy.fetch_and((uint8_t)~(1 << i));
+                return;
+            }
+        }
+        free(buffer);
+    }
+
+    static size_t formatIP(char* buffer, size_t size, const IPAddress& ip) {
+        int written = snprintf(buffer, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        return written < 0 ? 0 : std::min((size_t)written, size - 1);
+    }
+
 public:
     static void init(uint16_t port) {
         logPort = port;
@@ -54,8 +84,7 @@ public:
     }
 
     static int customLogFunction(esp_log_level_t level, const char* tag, const char* format, va_list args) {
-        enum { BUFFER_SIZE = 2048 };
-        char* logBuffer = (char*)malloc(BUFFER_SIZE); // Allocation dynamique plus sûre
+        char* logBuffer = claimLineBuffer();
         if (!logBuffer) return -1;
         
         int totalLen = 0;
@@ -67,16 +96,19 @@ public:
         const char* levelStr = getLevelString(level);
         unsigned long timestamp = millis();
         
-        // Construire l'information IP de manière sécurisée
-        String ipInfo;
+        // Construire l'information IP sans String
+        char ipInfo[48];
+        size_t ipLen = 0;
+        ipInfo[0] = '\0';
         if (WiFi.getMode() & WIFI_AP) {
-            ipInfo = WiFi.softAPIP().toString();
+            ipLen += formatIP(ipInfo, sizeof(ipInfo), WiFi.softAPIP());
         }
         if (WiFi.getMode() & WIFI_STA && WiFi.status() == WL_CONNECTED) {
-            if (ipInfo.length() > 0) {
-                ipInfo += "/";
+            if (ipLen > 0 && ipLen < sizeof(ipInfo) - 1) {
+                ipInfo[ipLen++] = '/';
+                ipInfo[ipLen] = '\0';
             }
-            ipInfo += WiFi.localIP().toString();
+            ipLen += formatIP(ipInfo + ipLen, sizeof(ipInfo) - ipLen, WiFi.localIP());
         }
 
         // Écrire le préfixe
@@ -84,12 +116,12 @@ public:
                         "%s%s \033[1;37m%lu\033[0m %.*s %s(\033[1m%s%s)\033[0m ",
                         levelColor, levelStr,
                         timestamp,
-                        std::min((int)ipInfo.length(), 45), // Limiter la longueur de l'IP
-                        ipInfo.c_str(),
+                        std::min((int)ipLen, 45), // Limiter la longueur de l'IP
+                        ipInfo,
                         levelColor, tag, levelColor);
 
         if (written < 0 || written >= remainingSpace) {
-            free(logBuffer);
+            releaseLineBuffer(logBuffer);
             return -1;
         }
 
@@ -129,7 +161,7 @@ public:
             }
         }
 
-        free(logBuffer);
+        releaseLineBuffer(logBuffer);
         return totalLen;
     }
 
@@ -145,6 +177,8 @@ WiFiUDP CustomLogger::udp;
 uint16_t CustomLogger::logPort;
 bool CustomLogger::initialized = false;
 IPAddress CustomLogger::broadcastIP;
+char CustomLogger::lineBuffers[CustomLogger::LINE_BUFFERS][CustomLogger::BUFFER_SIZE];
+std::atomic<uint8_t> CustomLogger::lineBusy{0};
 
 #define CUSTOM_LOGE(tag, format, ...) CustomLogger::log(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
 #define CUSTOM_LOGW(tag, format, ...) CustomLogger::log(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
@@ -22,6 +22,7 @@ private:
         config["network"]["log_port"] = 8888;
         config["update"]["base_url"] = "https://bitbucket.org/ccoupel/buzzcontrol/raw/main/data";
         config["update"]["version_file"] = "/config/version.txt";
+        config["storage"]["save_window_ms"] = 2000;
     }
     
 public:
@@ -134,6 +135,11 @@ public:
     String getVersionFile() {
         return config["update"]["version_file"].as<String>();
     }
+
+    // Getter for storage configuration
+    uint32_t getSaveWindowMs() {
+        return config["storage"]["save_window_ms"] | 2000;
+    }
     
     // Setters
     void setWifiCredentials(const String& ssid, const String& password) {
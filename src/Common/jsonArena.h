@@ -0,0 +1,215 @@
+#pragma once
+#include "Common/CustomLogger.h"
+
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const char* ARENA_TAG = "JSON_ARENA";
+
+// Allocateur ArduinoJson par tâche: les documents d'un message sont alloués en pile
+// dans un tampon fixe, puis libérés d'un coup par reset() une fois le message traité.
+// Un débordement se replie sur le tas et est compté.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    explicit JsonArena(const char* name, size_t capacity) : name_(name), capacity_(capacity) {}
+
+    void* allocate(size_t size) override {
+        size_t needed = HEADER + align(size);
+        if (!ensureBuffer() || offset_ + needed > capacity_) {
+            overflows_++;
+            return malloc(size);
+        }
+        uint8_t* block = buffer_ + offset_;
+        *(size_t*)block = size;
+        last_ = offset_;
+        offset_ += needed;
+        liveBlocks_++;
+        if (offset_ > highWater_) highWater_ = offset_;
+        return block + HEADER;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!owns(ptr)) {
+            free(ptr);
+            return;
+        }
+        liveBlocks_--;
+        // Seul le dernier bloc est rendu tout de suite, les autres attendent reset()
+        if ((uint8_t*)ptr - HEADER == buffer_ + last_) {
+            offset_ = last_;
+            last_ = NO_BLOCK;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (ptr == nullptr) return allocate(newSize);
+        if (!owns(ptr)) return realloc(ptr, newSize);
+
+        uint8_t* block = (uint8_t*)ptr - HEADER;
+        size_t oldSize = *(size_t*)block;
+        // Dernier bloc: on l'étend ou le réduit sur place
+        if (block == buffer_ + last_ && last_ + HEADER + align(newSize) <= capacity_) {
+            *(size_t*)block = newSize;
+            offset_ = last_ + HEADER + align(newSize);
+            if (offset_ > highWater_) highWater_ = offset_;
+            return ptr;
+        }
+        if (newSize <= oldSize) {
+            return ptr;
+        }
+        void* moved = allocate(newSize);
+        if (moved != nullptr) {
+            memcpy(moved, ptr, oldSize);
+            deallocate(ptr);
+        }
+        return moved;
+    }
+
+    // À appeler quand plus aucun document de la tâche n'est vivant
+    void reset() {
+        if (liveBlocks_ != 0) {
+            ESP_LOGW(ARENA_TAG, "%s reset with %d live blocks", name_, liveBlocks_);
+        }
+        offset_ = 0;
+        last_ = NO_BLOCK;
+        liveBlocks_ = 0;
+    }
+
+    void logUsage() const {
+        ESP_LOGD(ARENA_TAG, "%s high water %zu/%zu bytes, %u heap fallbacks", name_, highWater_, capacity_, (unsigned)overflows_);
+    }
+
+    const char* name() const { return name_; }
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return offset_; }
+    size_t highWater() const { return highWater_; }
+    uint32_t overflows() const { return overflows_; }
+
+private:
+    static constexpr size_t HEADER = 8;
+    static constexpr size_t NO_BLOCK = (size_t)-1;
+
+    static size_t align(size_t size) { return (size + 7) & ~(size_t)7; }
+
+    bool owns(const void* ptr) const {
+        return buffer_ != nullptr && ptr >= buffer_ && ptr < buffer_ + capacity_;
+    }
+
+    // Tampon réservé une fois, au premier message
+    bool ensureBuffer() {
+        if (buffer_ == nullptr) {
+            buffer_ = (uint8_t*)malloc(capacity_);
+            if (buffer_ == nullptr) {
+                ESP_LOGE(ARENA_TAG, "%s: unable to reserve %zu bytes", name_, capacity_);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const char* name_;
+    size_t capacity_;
+    uint8_t* buffer_ = nullptr;
+    size_t offset_ = 0;
+    size_t last_ = NO_BLOCK;
+    size_t highWater_ = 0;
+    uint32_t overflows_ = 0;
+    int liveBlocks_ = 0;
+};
+
+// Tas classique, pour les tâches sans arène
+class HeapJsonAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override { return malloc(size); }
+    void deallocate(void* ptr) override { free(ptr); }
+    void* reallocate(void* ptr, size_t newSize) override { return realloc(ptr, newSize); }
+};
+
+HeapJsonAllocator heapJsonAllocator;
+
+// Tas avec comptage des octets vivants: suit la taille réelle d'un document de longue durée
+class CountingJsonAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        uint8_t* block = (uint8_t*)malloc(HEADER + size);
+        if (block == nullptr) return nullptr;
+        *(size_t*)block = size;
+        grow(size);
+        return block + HEADER;
+    }
+
+    void deallocate(void* ptr) override {
+        if (ptr == nullptr) return;
+        uint8_t* block = (uint8_t*)ptr - HEADER;
+        used_ -= *(size_t*)block;
+        free(block);
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (ptr == nullptr) return allocate(newSize);
+        uint8_t* block = (uint8_t*)ptr - HEADER;
+        size_t oldSize = *(size_t*)block;
+        uint8_t* moved = (uint8_t*)realloc(block, HEADER + newSize);
+        if (moved == nullptr) return nullptr;
+        *(size_t*)moved = newSize;
+        used_ -= oldSize;
+        grow(newSize);
+        return moved + HEADER;
+    }
+
+    size_t used() const { return used_; }
+    size_t peak() const { return peak_; }
+
+private:
+    static constexpr size_t HEADER = 8;
+
+    void grow(size_t size) {
+        used_ += size;
+        if (used_ > peak_) peak_ = used_;
+    }
+
+    size_t used_ = 0;
+    size_t peak_ = 0;
+};
+
+//#### ARENE PAR TACHE ###
+#define MAX_TASK_ARENAS 4
+
+struct TaskArenaBinding {
+    TaskHandle_t task;
+    JsonArena* arena;
+};
+
+TaskArenaBinding taskArenas[MAX_TASK_ARENAS];
+
+// Associe l'arène à la tâche courante (appelé au démarrage de la tâche)
+void bindTaskArena(JsonArena* arena) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < MAX_TASK_ARENAS; i++) {
+        if (taskArenas[i].task == task || taskArenas[i].task == nullptr) {
+            taskArenas[i].task = task;
+            taskArenas[i].arena = arena;
+            return;
+        }
+    }
+    ESP_LOGE(ARENA_TAG, "No free arena binding for %s", arena->name());
+}
+
+// Allocateur des documents temporaires: l'arène de la tâche courante, sinon le tas
+ArduinoJson::Allocator* taskJsonAllocator() {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < MAX_TASK_ARENAS; i++) {
+        if (taskArenas[i].task == task) return taskArenas[i].arena;
+    }
+    return &heapJsonAllocator;
+}
+
+// Remet l'arène à zéro en sortie de portée (déclarer avant les documents)
+class JsonArenaScope {
+public:
+    explicit JsonArenaScope(JsonArena& arena) : arena_(arena) {}
+    ~JsonArenaScope() { arena_.reset(); }
+private:
+    JsonArena& arena_;
+};